@@ -13,10 +13,32 @@
 #include "main.h"
 
 
+#ifdef MD_BENCHMARK
+
+// Fixed input script for benchmark runs, each key is held for given number of frames.
+static const BenchmarkStep bench_path[] =
+{
+	{ 60, KEY_NONE },
+	{ 1, KEY_LEFT },
+	{ 60, KEY_UP },
+	{ 1, KEY_B },
+	{ 60, KEY_NONE },
+	{ 1, KEY_RIGHT },
+	{ 60, KEY_DOWN },
+	{ 1, KEY_B }
+};
+
+#endif // MD_BENCHMARK
+
 MDGame* MDGameCreate( System * system )
 {
+#ifdef MD_BENCHMARK
+	// Run game with fixed frame time and input script, results are written to benchmark log.
+	return new MDGameBenchmark( system, new GameProject( system ), "2d_test", bench_path, sizeof(bench_path) / sizeof(bench_path[0]) );
+#else
 	// Call constructor of GameProject here.
 	return new GameProject(system);
+#endif
 }
 
 void MDGameSetPreferences( MDGamePreferences & p)
@@ -249,7 +271,7 @@ void GameProject::Draw()
 	DrawTileMap(&objects);
 	
 	// sort draw queue by z order and draw it.
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 	
 	// draw SpriteTransform from actor with help SpriteTransform parameters
 	render->Draw(&help_st, actor.GetFrame());
@@ -295,14 +317,14 @@ void GameProject::Draw()
 	/**
 	 * As font only send text to draw queue we need to process draw queue again.
 	 */
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 //////////////////////////////////////////////////////////////////////////
 
 	/**
 	 * Only now copy backbuffer to video memory on display.
 	 */
-	render->Show();
+	MD_BENCH_SHOW( render );
 }
 
 void GameProject::DrawTileMap(TileMap* tile_map)
@@ -12,10 +12,31 @@
 
 
 
+#ifdef MD_BENCHMARK
+
+// Fixed input script for benchmark runs, each key is held for given number of frames.
+static const BenchmarkStep bench_path[] =
+{
+	{ 60, KEY_NONE },
+	{ 90, KEY_RIGHT },
+	{ 30, KEY_A },
+	{ 60, KEY_UP },
+	{ 90, KEY_LEFT },
+	{ 30, KEY_B },
+	{ 60, KEY_DOWN }
+};
+
+#endif // MD_BENCHMARK
+
 MDGame* MDGameCreate( System * system )
 {
+#ifdef MD_BENCHMARK
+	// Run game with fixed frame time and input script, results are written to benchmark log.
+	return new MDGameBenchmark( system, new GameProject( system ), "joint_animation", bench_path, sizeof(bench_path) / sizeof(bench_path[0]) );
+#else
 	// Call constructor of GameProject here.
 	return new GameProject( system );
+#endif
 }
 
 void MDGameSetPreferences( MDGamePreferences & p )
@@ -360,7 +381,7 @@ void GameProject::Draw()
 	// Reset texture matrix.
 	render->SetTextureIdentityMatrix();
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 
 	/**
@@ -409,7 +430,7 @@ void GameProject::Draw()
 	 * As font only send text to draw queue we need to process draw queue again.
 	 */
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -417,7 +438,7 @@ void GameProject::Draw()
 	 * Only now copy backbuffer to video memory on display.
 	 */
 
-	render->Show();
+	MD_BENCH_SHOW( render );
 
 //////////////////////////////////////////////////////////////////////////
 
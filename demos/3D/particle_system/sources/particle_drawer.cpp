@@ -107,7 +107,7 @@ void ParticleDrawer::Draw()
 	if(!render) return;
 
         // Flush the draw queue.
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 	
 	// If necessary, set lighting OFF.
 	if(!lighting)
@@ -134,7 +134,7 @@ void ParticleDrawer::Draw()
 	}
 
 	// Flush the draw queue.
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 	// If lighting was disabled, we should enable it.
 	if(!lighting)
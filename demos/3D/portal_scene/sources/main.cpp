@@ -11,10 +11,30 @@
 #include "main.h"
 
 
+#ifdef MD_BENCHMARK
+
+// Fixed input script for benchmark runs, each key is held for given number of frames.
+static const BenchmarkStep bench_path[] =
+{
+	{ 30, KEY_NONE },
+	{ 150, KEY_A },
+	{ 60, KEY_RIGHT },
+	{ 150, KEY_A },
+	{ 120, KEY_LEFT },
+	{ 90, KEY_B }
+};
+
+#endif // MD_BENCHMARK
+
 MDGame* MDGameCreate( System * system )
 {
+#ifdef MD_BENCHMARK
+	// Run game with fixed frame time and input script, results are written to benchmark log.
+	return new MDGameBenchmark( system, new GameProject( system ), "portal_scene", bench_path, sizeof(bench_path) / sizeof(bench_path[0]) );
+#else
 	// Call constructor of GameProject here.
 	return new GameProject( system );
+#endif
 }
 
 void MDGameSetPreferences( MDGamePreferences & p )
@@ -310,7 +330,7 @@ void GameProject::Draw()
 		out_of_portals[i]->Draw();
  
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 
 	/**
@@ -359,7 +379,7 @@ void GameProject::Draw()
 	 * As font only send text to draw queue we need to process draw queue again.
 	 */
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -367,7 +387,7 @@ void GameProject::Draw()
 	 * Only now copy backbuffer to video memory on display.
 	 */
 
-	render->Show();
+	MD_BENCH_SHOW( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -345,7 +345,7 @@ void GameProject::Draw()
 	actor->Draw();
  
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 
 	/**
@@ -395,7 +395,7 @@ void GameProject::Draw()
 	 * As font only send text to draw queue we need to process draw queue again.
 	 */
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -403,7 +403,7 @@ void GameProject::Draw()
 	 * Only now copy backbuffer to video memory on display.
 	 */
 
-	render->Show();
+	MD_BENCH_SHOW( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -11,10 +11,32 @@
 #include "main.h"
 
 
+#ifdef MD_BENCHMARK
+
+// Fixed input script for benchmark runs, each key is held for given number of frames.
+static const BenchmarkStep bench_path[] =
+{
+	{ 30, KEY_NONE },
+	{ 120, KEY_A },
+	{ 60, KEY_LEFT },
+	{ 120, KEY_A },
+	{ 90, KEY_RIGHT },
+	{ 60, KEY_B },
+	{ 30, KEY_UP },
+	{ 30, KEY_DOWN }
+};
+
+#endif // MD_BENCHMARK
+
 MDGame* MDGameCreate( System * system )
 {
+#ifdef MD_BENCHMARK
+	// Run game with fixed frame time and input script, results are written to benchmark log.
+	return new MDGameBenchmark( system, new GameProject( system ), "static_scene", bench_path, sizeof(bench_path) / sizeof(bench_path[0]) );
+#else
 	// Call constructor of GameProject here.
 	return new GameProject( system );
+#endif
 }
 
 void MDGameSetPreferences( MDGamePreferences & p )
@@ -324,7 +346,7 @@ void GameProject::Draw()
 	// Draw sky.
 	sky[0]->Draw();
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 	
 	// Return switched modes for render.
 	render->ClearMode(Render_BackToFront_Mode);
@@ -342,7 +364,7 @@ void GameProject::Draw()
 		o3dlist[0][i]->Draw();
 	}
  
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 
 	/**
@@ -391,7 +413,7 @@ void GameProject::Draw()
 	 * As font only send text to draw queue we need to process draw queue again.
 	 */
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -399,7 +421,7 @@ void GameProject::Draw()
 	 * Only now copy backbuffer to video memory on display.
 	 */
 
-	render->Show();
+	MD_BENCH_SHOW( render );
 
 //////////////////////////////////////////////////////////////////////////
 
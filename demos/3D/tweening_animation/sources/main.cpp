@@ -11,10 +11,31 @@
 #include "main.h"
 
 
+#ifdef MD_BENCHMARK
+
+// Fixed input script for benchmark runs, each key is held for given number of frames.
+static const BenchmarkStep bench_path[] =
+{
+	{ 60, KEY_NONE },
+	{ 90, KEY_RIGHT },
+	{ 30, KEY_A },
+	{ 60, KEY_UP },
+	{ 90, KEY_LEFT },
+	{ 30, KEY_B },
+	{ 60, KEY_DOWN }
+};
+
+#endif // MD_BENCHMARK
+
 MDGame* MDGameCreate( System * system )
 {
+#ifdef MD_BENCHMARK
+	// Run game with fixed frame time and input script, results are written to benchmark log.
+	return new MDGameBenchmark( system, new GameProject( system ), "tweening_animation", bench_path, sizeof(bench_path) / sizeof(bench_path[0]) );
+#else
 	// Call constructor of GameProject here.
 	return new GameProject( system );
+#endif
 }
 
 void MDGameSetPreferences( MDGamePreferences & p )
@@ -55,6 +76,8 @@ GameProject::~GameProject()
 
 	//animations_list.clear();
 
+	morph_caches.Clear();
+
 	font.Free();
 }
 
@@ -141,6 +164,12 @@ Bool GameProject::Init()
 	// Disable Fog.
 	render->ClearMode(Render_Fog_Mode);
 
+#ifdef MD_BENCHMARK
+	// Compare batch morphing with per vertex morphing for both VB layouts.
+	MDGameBenchmark::MorphMicroBenchmark();
+	MDGameBenchmark::MorphMicroBenchmark( 1000, 1000, True );
+#endif
+
 	return True;
 }
 
@@ -273,9 +302,10 @@ void GameProject::Draw()
 	// Set normal view matrix.
 	render->SetView(&view_mx);
 
-	actor->Draw();
+	// Nodes are not morphed again while animation stands still.
+	actor->Draw( morph_caches );
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 
 	/**
@@ -325,7 +355,7 @@ void GameProject::Draw()
 	 * As font only send text to draw queue we need to process draw queue again.
 	 */
 
-	render->Flush();
+	MD_BENCH_FLUSH( render );
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -333,7 +363,7 @@ void GameProject::Draw()
 	 * Only now copy backbuffer to video memory on display.
 	 */
 
-	render->Show();
+	MD_BENCH_SHOW( render );
 
 //////////////////////////////////////////////////////////////////////////
 
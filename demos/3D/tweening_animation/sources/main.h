@@ -74,6 +74,9 @@ public:
 	// Object to play animation.
 	ObjRef<Actor3D> actor;
 
+	// Morphing results of actor nodes, kept between frames.
+	MorphCacheMap morph_caches;
+
 	// Camera
 	Camera camera;
 
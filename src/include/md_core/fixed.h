@@ -28,7 +28,7 @@ namespace mdragon
 
 	#endif // MD_OS_SYMBIAN_S60
 
-	#if defined(MD_OS_WINCE) || defined(MD_OS_WIN32) || defined(MD_OS_PALM) || defined(PSP)
+	#if defined(MD_OS_WINCE) || defined(MD_OS_WIN32) || defined(MD_OS_PALM) || defined(MD_OS_LINUX) || defined(PSP)
 	#undef FixedMul
 	#undef FixedDiv
 	#define FixedMul(x,y) ( (Int) ( ( (Long)(x) * (y) ) >> 16 ) )
@@ -188,6 +188,8 @@ public:
 	Int value;
 };
 
+MD_TL_RELOCATABLE(Fixed)
+
 
 ///////////////////////////////////////////////////////////////////
 // Operator +
@@ -0,0 +1,572 @@
+/** \file
+ *	Deterministic benchmark runner for MobileDragon applications. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_MDBENCHMARK_H__
+#define __MD_MDBENCHMARK_H__
+
+namespace mdragon
+{
+
+/// Number of frames to run if not defined in mdconfig.h.
+#ifndef MD_BENCH_FRAMES
+#define MD_BENCH_FRAMES 600
+#endif
+
+/// Fixed frame time in system ticks if not defined in mdconfig.h.
+#ifndef MD_BENCH_FRAME_TIME
+#define MD_BENCH_FRAME_TIME 33
+#endif
+
+/// 1 to sort Render3D draw queue by DepthSorter in MD_BENCH_FLUSH(), 0 to leave it to Flush().
+#ifndef MD_BENCH_DEPTH_SORT
+#define MD_BENCH_DEPTH_SORT 1
+#endif
+
+/// Name of log file benchmark results are appended to.
+#ifndef MD_BENCH_LOG_NAME
+#define MD_BENCH_LOG_NAME "mdbench"
+#endif
+
+/// Byte value free System pool is filled with to find its peak use.
+#define MDGameBenchmark_Pool_Paint 0xCD
+
+/// Flushes Render2D or Render3D draw queue, timed by running MDGameBenchmark and Render3DProfiler.
+/**
+ *	Use it in application instead of render->Flush().
+ */
+#define MD_BENCH_FLUSH(render) MDGameBenchmark::Flush( render )
+
+/// Shows Render2D or Render3D frame and ends Render3DProfiler frame.
+/**
+ *	Use it in application instead of render->Show().
+ */
+#define MD_BENCH_SHOW(render) MDGameBenchmark::Show( render )
+
+
+/// One step of scripted benchmark input.
+/**
+ *	Key is held down for given number of frames. Demo applications move
+ *	camera by fixed increment per Update() call, so list of steps gives
+ *	fixed camera path.
+ */
+struct BenchmarkStep
+{
+	/// Number of frames to hold the key.
+	Int frames;
+
+	/// Key code, see KEY_XXX defines. KEY_NONE for no input.
+	Int key;
+};
+
+
+/// Deterministic benchmark wrapper for MDGame.
+/**
+ *	Drives wrapped application for fixed number of frames with fixed frame
+ *	time and scripted input, then appends one line of results in JSON
+ *	format to MD_BENCH_LOG_NAME log and exits. <br>
+ *	Render2D::Flush() and Render3D::Flush() calls made by MD_BENCH_FLUSH()
+ *	are timed separately. Triangles drawn are triangles left in Render3D
+ *	draw queue at Flush() call, that is after clipping and culling done by
+ *	Draw(). Triangles submitted to Draw() are not counted, Object3D and
+ *	Actor3D send them from library code. If MD_BENCH_DEPTH_SORT is 1,
+ *	Render3D queue is sorted by Render3D::SortQueue() before Flush(), sort
+ *	time is included in Flush() time and also reported alone. <br>
+ *	Free System pool is filled with MDGameBenchmark_Pool_Paint before
+ *	each frame and scanned after it, so pool peak includes space taken and
+ *	returned by RestorePool() inside Update(), Draw() and Flush().
+ *	Use it from MDGameCreate():
+ *	\code
+ *	return new MDGameBenchmark( system, new GameProject( system ), "scene", path, path_size );
+ *	\endcode
+ */
+class MDGameBenchmark : public MDGame
+{
+public:
+
+	MD_TRACKED_OBJECT( MDGameBenchmark )
+
+	/// Constructor.
+	/**
+	 *	@param system_ - pointer to System class object.
+	 *	@param game_ - application to run, will be deleted by benchmark.
+	 *	@param name_ - scene name written to results.
+	 *	@param path_ - array of input steps, repeated if shorter than frames_.
+	 *	@param path_size_ - number of elements in path_.
+	 *	@param frames_ - number of frames to run.
+	 *	@param frame_time_ - system ticks added per frame.
+	 */
+	MDGameBenchmark( System* system_, MDGame* game_, const Char* name_,
+			const BenchmarkStep* path_, Int path_size_,
+			Int frames_ = MD_BENCH_FRAMES, Int frame_time_ = MD_BENCH_FRAME_TIME )
+	{
+		system = system_;
+		game = game_;
+		name = name_;
+		path = path_;
+		path_size = path_size_;
+		frames = frames_;
+		frame_time = frame_time_;
+		frame = 0;
+		step = 0;
+		step_frame = 0;
+		start_ticks = 0;
+		update_ticks = 0;
+		draw_ticks = 0;
+		overhead_ticks = 0;
+		flush3d_ticks = 0;
+		flush2d_ticks = 0;
+		flush3d_count = 0;
+		flush2d_count = 0;
+		sort_ticks = 0;
+		triangles_drawn = 0;
+		pool_peak = 0;
+		pool_dirty = 0;
+		paint = NULL;
+		paint_size = 0;
+		paint_used = 0;
+
+		Current() = this;
+	}
+
+	/// Destructor. Deletes wrapped application.
+	~MDGameBenchmark()
+	{
+		if( Current() == this )
+			Current() = NULL;
+
+		delete game;
+	}
+
+	/// Flushes Render3D draw queue and adds time and triangles to running benchmark.
+	static void Flush( Render3D* render )
+	{
+		RENDER3D_PROFILE_SCOPE( Render3D_Stage_Flush )
+
+		MDGameBenchmark* bench = Current();
+		if( !bench )
+		{
+			render->Flush();
+			return;
+		}
+
+		bench->triangles_drawn += render->tri_heap_count;
+		bench->flush3d_count++;
+
+		DWord ticks = GetMicroTickCount();
+
+#if MD_BENCH_DEPTH_SORT
+		render->SortQueue( bench->depth_sorter );
+		bench->sort_ticks += GetMicroTickCount() - ticks;
+#endif
+
+		render->Flush();
+		bench->flush3d_ticks += GetMicroTickCount() - ticks;
+	}
+
+	/// Flushes Render2D draw queue and adds time to running benchmark.
+	static void Flush( Render2D* render )
+	{
+		MDGameBenchmark* bench = Current();
+		if( !bench )
+		{
+			render->Flush();
+			return;
+		}
+
+		bench->flush2d_count++;
+
+		DWord ticks = GetMicroTickCount();
+		render->Flush();
+		bench->flush2d_ticks += GetMicroTickCount() - ticks;
+	}
+
+	/// Shows Render3D frame and ends Render3DProfiler frame.
+	static void Show( Render3D* render )
+	{
+		{
+			RENDER3D_PROFILE_SCOPE( Render3D_Stage_Show )
+			render->Show();
+		}
+
+		RENDER3D_PROFILE_END_FRAME()
+	}
+
+	/// Shows Render2D frame.
+	static void Show( Render2D* render )
+	{
+		render->Show();
+	}
+
+	/// Initializes wrapped application and resets all counters.
+	Bool Init()
+	{
+		system->ticks = 0;
+
+		if( !game->Init() )
+			return False;
+
+#ifdef MD_RENDER3D_PROFILE
+		Render3DProfiler::Instance().Reset();
+#endif
+
+		pool_peak = 0;
+		pool_dirty = system->PoolSize();
+		SamplePool();
+
+		start_ticks = GetMicroTickCount();
+
+		return True;
+	}
+
+	/// Runs one frame of wrapped application with fixed time and scripted input.
+	Bool Update()
+	{
+		if( frame >= frames )
+		{
+			Report();
+			system->Exit();
+			return False;
+		}
+
+		system->ticks = frame * frame_time;
+
+		TKeyboard keyboard;
+		memset( &keyboard, 0, sizeof(keyboard) );
+
+		if( path_size )
+		{
+			if( step_frame >= path[step].frames )
+			{
+				step = ( step + 1 ) % path_size;
+				step_frame = 0;
+			}
+
+			if( path[step].key != KEY_NONE )
+				keyboard.KeyPressed[ path[step].key ] = 1;
+
+			step_frame++;
+		}
+
+		// Pen is placed out of exit areas used by demos.
+		Short pen_x = 0x7FFF, pen_y = 0x7FFF;
+		Bool pen_down = False;
+		system->input.Update( &keyboard, &pen_x, &pen_y, &pen_down );
+
+		frame++;
+
+		DWord ticks = GetMicroTickCount();
+		PaintPool();
+		overhead_ticks += GetMicroTickCount() - ticks;
+
+		ticks = GetMicroTickCount();
+		Bool draw = game->Update();
+		update_ticks += GetMicroTickCount() - ticks;
+
+		if( !draw )
+		{
+			ticks = GetMicroTickCount();
+			SamplePool();
+			overhead_ticks += GetMicroTickCount() - ticks;
+		}
+
+		return draw;
+	}
+
+	/// Draws one frame of wrapped application.
+	void Draw()
+	{
+		DWord ticks = GetMicroTickCount();
+		game->Draw();
+		draw_ticks += GetMicroTickCount() - ticks;
+
+#if defined(MD_TL_DEBUG) && !defined(Fixed)
+		// Origin of last world matrix projected by batch kernel and by Render3D.
+		Vector3fx origin( 0, 0, 0 );
+		if( system->render3d )
+			assert( CheckVertexTransform( *system->render3d, origin ) );
+#endif
+
+		ticks = GetMicroTickCount();
+		SamplePool();
+		overhead_ticks += GetMicroTickCount() - ticks;
+	}
+
+	/// Compares batch morphing with per vertex morphing.
+	/**
+	 *	Morphs two VBs with random vertices and normals by per vertex
+	 *	ReadVxyz()/WriteVxyz() code and by MorphVertexBuffer(), and appends
+	 *	one line of results to MD_BENCH_LOG_NAME log.
+	 *	@param vertex_count - number of vertices in VB, up to 0xFFFF.
+	 *	@param iterations - number of morphs by each method.
+	 *	@param soa - True to morph VertexBufferSoA copies of VBs by batch path.
+	 */
+	static void MorphMicroBenchmark( Int vertex_count = 1000, Int iterations = 1000, Bool soa = False )
+	{
+		assert( vertex_count > 0 && vertex_count <= 0xFFFF );
+
+		Int format = VertexBuffer_Format_Vxyz | VertexBuffer_Format_Nxyz;
+		ObjRef<VertexBuffer> vb[4];
+		Randomize rnd( 1 );
+
+		for( Int k = 0; k < 4; k++ )
+		{
+			vb[k] = VertexBuffer::New();
+			if( !vb[k]->Init( format, (Word)vertex_count, 0 ) )
+				return;
+
+			vb[k]->Lock( VertexBuffer_LockType_Write );
+			for( Int i = 0; i < vertex_count; i++ )
+			{
+				Fixed v[3];
+				for( Int c = 0; c < 3; c++ )
+					v[c] = Fixed( (Int)( rnd() & 0xFFFFFF ) - 0x800000, 0 );
+				vb[k]->WriteVxyz( i, v );
+				vb[k]->WriteNxyz( i, v );
+			}
+			vb[k]->UnLock();
+		}
+
+		Fixed li( 0x5A5A, 0 );
+
+		// Per vertex path.
+		DWord ticks = GetMicroTickCount();
+		for( Int n = 0; n < iterations; n++ )
+		{
+			vb[0]->Lock( VertexBuffer_LockType_Read );
+			vb[1]->Lock( VertexBuffer_LockType_Read );
+			vb[2]->Lock( VertexBuffer_LockType_Write );
+
+			for( Int i = 0; i < vertex_count; i++ )
+			{
+				Fixed a[3], b[3], r[3];
+
+				vb[0]->ReadVxyz( i, a );
+				vb[1]->ReadVxyz( i, b );
+				for( Int c = 0; c < 3; c++ )
+					r[c] = a[c] + ( b[c] - a[c] ) * li;
+				vb[2]->WriteVxyz( i, r );
+
+				vb[0]->ReadNxyz( i, a );
+				vb[1]->ReadNxyz( i, b );
+				for( Int c = 0; c < 3; c++ )
+					r[c] = a[c] + ( b[c] - a[c] ) * li;
+				vb[2]->WriteNxyz( i, r );
+			}
+
+			vb[2]->UnLock();
+			vb[1]->UnLock();
+			vb[0]->UnLock();
+		}
+		DWord vertex_ticks = GetMicroTickCount() - ticks;
+
+		// Batch path.
+		VertexBufferSoA soa_vb[3];
+		if( soa && ( !soa_vb[0].Load( *vb[0] ) || !soa_vb[1].Load( *vb[1] ) || !soa_vb[2].Init( format, vertex_count ) ) )
+			return;
+
+		ticks = GetMicroTickCount();
+		for( Int n = 0; n < iterations; n++ )
+		{
+			if( soa )
+				MorphVertexBuffer( soa_vb[2], soa_vb[0], soa_vb[1], li, True );
+			else
+				MorphVertexBuffer( *vb[3], *vb[0], *vb[1], li, True );
+		}
+		DWord batch_ticks = GetMicroTickCount() - ticks;
+
+		if( soa )
+			soa_vb[2].Store( *vb[3] );
+
+		Bool identical = True;
+		vb[2]->Lock( VertexBuffer_LockType_Read );
+		vb[3]->Lock( VertexBuffer_LockType_Read );
+		for( Int i = 0; i < vertex_count && identical; i++ )
+		{
+			Fixed a[3], b[3];
+			vb[2]->ReadVxyz( i, a );
+			vb[3]->ReadVxyz( i, b );
+			identical = a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+		}
+		vb[3]->UnLock();
+		vb[2]->UnLock();
+
+		if( batch_ticks == 0 )
+			batch_ticks = 1;
+
+		string s = "{\"micro\":\"morph\",\"vertices\":";
+		s << string( vertex_count ) << ",\"iterations\":" << string( iterations );
+		s << ",\"soa\":" << ( soa ? "true" : "false" );
+		s << ",\"per_vertex_ms\":"; AppendMilli( s, vertex_ticks );
+		s << ",\"batch_ms\":"; AppendMilli( s, batch_ticks );
+		s << ",\"speedup\":"; AppendMilli( s, (Long)vertex_ticks * 1000 / batch_ticks );
+		s << ",\"identical\":" << ( identical ? "true" : "false" ) << "}\n";
+
+		Log log( MD_BENCH_LOG_NAME, True );
+		log << s;
+	}
+
+private:
+
+	/// Appends value / 1000 with 3 decimal digits.
+	static void AppendMilli( string& s, Long value )
+	{
+		if( value < 0 )
+		{
+			s << "-";
+			value = -value;
+		}
+
+		Int frac = (Int)( value % 1000 );
+		s << string( (Int)( value / 1000 ) ) << ".";
+		if( frac < 100 ) s << "0";
+		if( frac < 10 ) s << "0";
+		s << string( frac );
+	}
+
+	/// Returns running benchmark.
+	static MDGameBenchmark*& Current()
+	{
+		static MDGameBenchmark* current = NULL;
+		return current;
+	}
+
+	/// Fills free System pool with MDGameBenchmark_Pool_Paint.
+	/**
+	 *	Only bytes which could be changed since last fill are written.
+	 */
+	void PaintPool()
+	{
+		Int free_;
+		system->SavePool( &paint_used, &free_ );
+
+		paint_size = ( system->FreePoolSize() - 8 ) & ~3;
+		paint = paint_size > 0 ? system->GetPool( paint_size ) : NULL;
+
+		if( paint && pool_dirty > paint_used )
+			memset( paint, MDGameBenchmark_Pool_Paint, min( paint_size, pool_dirty - paint_used ) );
+
+		system->RestorePool( paint_used, free_ );
+	}
+
+	/// Updates max used System pool size.
+	/**
+	 *	Highest byte of pool filled by PaintPool() which was changed is
+	 *	taken as peak. Data equal to MDGameBenchmark_Pool_Paint at the top
+	 *	of used space is not seen.
+	 */
+	void SamplePool()
+	{
+		Int used = system->PoolSize() - system->FreePoolSize();
+		Int peak = used;
+
+		if( paint )
+		{
+			Int i = paint_size;
+			while( i > 0 && paint[i - 1] == MDGameBenchmark_Pool_Paint )
+				i--;
+
+			peak = max( peak, paint_used + i );
+			paint = NULL;
+		}
+
+		pool_dirty = peak;
+
+		if( peak > pool_peak )
+			pool_peak = peak;
+	}
+
+	/// Writes results line to benchmark log.
+	void Report()
+	{
+		DWord wall_ticks = GetMicroTickCount() - start_ticks - overhead_ticks;
+		if( wall_ticks == 0 )
+			wall_ticks = 1;
+
+		string s = "{\"scene\":\"";
+		s << name << "\",\"frames\":" << string( frames );
+		s << ",\"frame_time\":" << string( frame_time );
+		s << ",\"wall_ms\":"; AppendMilli( s, wall_ticks );
+		s << ",\"fps\":"; AppendMilli( s, (Long)frames * 1000000 * 1000 / wall_ticks );
+		s << ",\"update_ms\":"; AppendMilli( s, (Long)update_ticks / frames );
+		s << ",\"draw_ms\":"; AppendMilli( s, (Long)draw_ticks / frames );
+		s << ",\"flush3d_ms\":"; AppendMilli( s, (Long)flush3d_ticks / ( flush3d_count ? flush3d_count : 1 ) );
+		s << ",\"flush3d_calls\":" << string( flush3d_count );
+		s << ",\"flush2d_ms\":"; AppendMilli( s, (Long)flush2d_ticks / ( flush2d_count ? flush2d_count : 1 ) );
+		s << ",\"flush2d_calls\":" << string( flush2d_count );
+		s << ",\"triangles_drawn\":" << string( (Int)( triangles_drawn / frames ) );
+
+#if MD_BENCH_DEPTH_SORT
+		s << ",\"depth_sort_ms\":"; AppendMilli( s, (Long)sort_ticks / ( flush3d_count ? flush3d_count : 1 ) );
+		s << ",\"depth_sort_incremental\":" << string( depth_sorter.GetIncrementalCount() );
+		s << ",\"depth_sort_full\":" << string( depth_sorter.GetFullCount() );
+#endif
+
+#ifdef MD_RENDER3D_PROFILE
+		static const Char* stage_names[Render3D_Stage_Count] = { "transform", "morph", "sort", "occlusion", "flush", "show", "submit" };
+		const Render3DFrameProfile& pr = Render3DProfiler::Instance().GetTotal();
+		Long profiled = pr.frame ? pr.frame : 1;
+
+		for( Int i = 0; i < Render3D_Stage_Count; i++ )
+		{
+			s << ",\"" << stage_names[i] << "_ms\":";
+			AppendMilli( s, (Long)pr.stage_ticks[i] / profiled );
+		}
+
+		s << ",\"vertices_transformed\":" << string( (Int)pr.vertices_transformed );
+		s << ",\"vertices_morphed\":" << string( (Int)pr.vertices_morphed );
+		s << ",\"triangles_sorted\":" << string( (Int)pr.triangles_sorted );
+#endif
+
+		s << ",\"pool_peak\":" << string( pool_peak );
+		s << ",\"pool_size\":" << string( system->PoolSize() );
+
+		s << "}\n";
+
+		Log log( MD_BENCH_LOG_NAME, True );
+		log << s;
+	}
+
+	System* system;
+	MDGame* game;
+
+	string name;
+
+	const BenchmarkStep* path;
+	Int path_size;
+
+	Int frames;
+	Int frame_time;
+	Int frame;
+
+	Int step;
+	Int step_frame;
+
+	DWord start_ticks;
+	DWord update_ticks;
+	DWord draw_ticks;
+	DWord overhead_ticks;
+
+	DWord flush3d_ticks;
+	DWord flush2d_ticks;
+	Int flush3d_count;
+	Int flush2d_count;
+	Long triangles_drawn;
+
+	DWord sort_ticks;
+	DepthSorter depth_sorter;
+
+	Int pool_peak;
+	Int pool_dirty;
+
+	Byte* paint;
+	Int paint_size;
+	Int paint_used;
+};
+
+} // namespace mdragon
+
+#endif // __MD_MDBENCHMARK_H__
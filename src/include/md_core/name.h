@@ -0,0 +1,182 @@
+/** \file
+ *	Interned names. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_NAME_H__
+#define __MD_NAME_H__
+
+namespace mdragon
+{
+
+/// Identifier of interned name, see NameTable.
+typedef DWord NameID;
+
+/// NameID of empty name.
+#define Name_Empty				0
+
+/// NameID returned by NameTable::Find() for name never interned.
+#define Name_Unknown			0xffffffffUL
+
+
+/// Global table of unique names.
+/**
+ *	Every distinct name is stored once and gets NameID, a small integer
+ *	given in order of interning. Stored strings are never freed or moved.
+ *	Engine objects keep their own string names, so GetNameID() of an
+ *	object interns its name on every call: hash and string compare. Take
+ *	ids once at load time and keep them, see Actor3DAnimationIndex.
+ */
+class NameTable
+{
+public:
+
+	/// Returns table instance.
+	static NameTable& Instance()
+	{
+		static NameTable table;
+		return table;
+	}
+
+	/// Returns id of name, adds name to table if needed.
+	/**
+	 *	@param s - name, NULL or empty string give Name_Empty.
+	 *	@return Returns name id.
+	 */
+	NameID Intern( const Char* s )
+	{
+		if( !s || !*s )
+			return Name_Empty;
+
+		DWord h = hash_string( s );
+		hash_map<const Char*, NameID>::iterator i = index.find( s, h );
+		if( i != index.end() )
+			return i->second;
+
+		strings.Add( string( s ) );
+
+		NameID id = strings.Size();
+		index.insert( strings[ id - 1 ].c_str(), id );
+		return id;
+	}
+
+	/// Returns id of name without adding it.
+	/**
+	 *	@param s - name.
+	 *	@return Returns name id, or Name_Unknown if name is not in table, so it matches no object.
+	 */
+	NameID Find( const Char* s )
+	{
+		if( !s || !*s )
+			return Name_Empty;
+
+		hash_map<const Char*, NameID>::iterator i = index.find( s );
+		return i != index.end() ? i->second : Name_Unknown;
+	}
+
+	/// Returns name by id.
+	/**
+	 *	@param id - name id.
+	 *	@return Returns stored name, empty string for Name_Empty or unknown id.
+	 */
+	inline const string& GetString( NameID id )
+	{
+		return id && id <= (NameID)strings.Size() ? strings[ id - 1 ] : empty;
+	}
+
+	/// Returns number of names in table.
+	inline Int GetCount() { return strings.Size(); }
+
+private:
+
+	NameTable() { ; }
+
+	NameTable( const NameTable& );
+	NameTable& operator = ( const NameTable& );
+
+	/// Names by id - 1, SVector does not move them.
+	SVector<string> strings;
+
+	/// Ids by stored name.
+	hash_map<const Char*, NameID> index;
+
+	string empty;
+};
+
+
+/// Interned name.
+/**
+ *	Holds only NameID. Converts to const string &, so it is used as string
+ *	for reading, while comparison of two Names is comparison of integers.
+ */
+class Name
+{
+public:
+
+	/// Default constructor. Creates empty name.
+	inline Name() { id = Name_Empty; }
+
+	/// Construct from string, interns it.
+	inline Name( const Char* s ) { id = NameTable::Instance().Intern( s ); }
+
+	/// Construct from string, interns it.
+	inline Name( const string& s ) { id = NameTable::Instance().Intern( s.c_str() ); }
+
+	/// Assigns string, interns it.
+	inline Name& operator = ( const Char* s )
+	{
+		id = NameTable::Instance().Intern( s );
+		return *this;
+	}
+
+	/// Assigns string, interns it.
+	inline Name& operator = ( const string& s )
+	{
+		id = NameTable::Instance().Intern( s.c_str() );
+		return *this;
+	}
+
+	/// Returns name id.
+	inline NameID GetID() const { return id; }
+
+	/// Returns True if name is empty.
+	inline Bool IsEmpty() const { return id == Name_Empty; }
+
+	/// Returns name string.
+	inline const string& GetString() const { return NameTable::Instance().GetString( id ); }
+
+	/// Returns pointer to name characters.
+	inline const Char* c_str() const { return GetString().c_str(); }
+
+	/// Conversion to string.
+	inline operator const string& () const { return GetString(); }
+
+	/// Equality comparison, compares ids.
+	inline Bool operator == ( const Name& src ) const { return id == src.id; }
+
+	/// Inequality comparison, compares ids.
+	inline Bool operator != ( const Name& src ) const { return id != src.id; }
+
+	/// Equality comparison with plain string, does not intern it.
+	inline Bool operator == ( const Char* s ) const { return id == NameTable::Instance().Find( s ); }
+
+	/// Inequality comparison with plain string, does not intern it.
+	inline Bool operator != ( const Char* s ) const { return !( *this == s ); }
+
+private:
+	NameID id;
+};
+
+MD_TL_RELOCATABLE(Name)
+
+template<>
+struct hash<Name>
+{
+	inline DWord operator () ( const Name& key ) const { return hash_int( key.GetID() ); }
+};
+
+} //namespace mdragon
+
+#endif // __MD_NAME_H__
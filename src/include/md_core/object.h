@@ -73,6 +73,15 @@ public:
 			p_object->AddRef();
 	}
 
+#ifdef MD_TL_RVALUE_REFERENCES
+	/// Move constructor. Takes reference of src without touching reference counter.
+	inline ObjRef( ObjRef<T> && src )
+	{
+		p_object = src.p_object;
+		src.p_object = NULL;
+	}
+#endif
+
 
 	/// Construct from plain pointer.
 	/**
@@ -103,6 +112,22 @@ public:
 	 */
 	ObjRef & operator = ( const ObjRef<T> & src );
 
+#ifdef MD_TL_RVALUE_REFERENCES
+	/// Move assignment operator. Takes reference of src without touching its reference counter.
+	ObjRef & operator = ( ObjRef<T> && src )
+	{
+		if( this != &src )
+		{
+			Object* old = p_object;
+			p_object = src.p_object;
+			src.p_object = NULL;
+			if( old )
+				old->Release();
+		}
+		return *this;
+	}
+#endif
+
 	/// Conversion to plain T *.
 	inline operator T * ()
 	{
@@ -235,6 +260,178 @@ ObjRef<T> & ObjRef<T>::operator = ( const ObjRef<T> & src )
 }
 
 
+class WeakObject;
+
+/// Shared state of WeakObject and its WeakRef<T> references.
+class WeakRefBlock
+{
+public:
+
+	MD_OBJECT_POOL(WeakRefBlock)
+
+	/// Referenced object, NULL after object is destroyed.
+	WeakObject* object;
+
+	/// Number of WeakRef<T> using this block.
+	DWord weak_count;
+};
+
+
+/// Base class for Objects referenced by WeakRef<T>.
+/**
+ *	Derive from WeakObject instead of Object to use WeakRef<T>, so back
+ *	pointers like child to parent do not make reference cycles. Engine
+ *	classes derive from Object and keep strong references.
+ *	Weak references expire in WeakObject destructor, after destructors of
+ *	derived classes; WeakRef<T>::Lock() returns NULL reference as soon as
+ *	reference counter drops to zero.
+ */
+class WeakObject : public Object
+{
+public:
+
+	/// Constructor.
+	WeakObject() { weak_block = NULL; }
+
+	/// Copy constructor. Reference counter and weak references are not copied.
+	WeakObject( const WeakObject& ) : Object() { weak_block = NULL; }
+
+	/// Assignment operator. Reference counter and weak references are not changed.
+	WeakObject& operator = ( const WeakObject& ) { return *this; }
+
+	/// Destructor.
+	virtual ~WeakObject()
+	{
+		if( !weak_block )
+			return;
+
+		weak_block->object = NULL;
+		if( !weak_block->weak_count )
+			delete weak_block;
+	}
+
+	/// Returns weak reference block of this object, creating it if needed.
+	/**
+	 *	Used by WeakRef<T>, increments block weak counter.
+	 */
+	WeakRefBlock* AcquireWeakBlock()
+	{
+		if( !weak_block )
+		{
+			weak_block = new WeakRefBlock;
+			weak_block->object = this;
+			weak_block->weak_count = 0;
+		}
+
+		weak_block->weak_count++;
+		return weak_block;
+	}
+
+private:
+	WeakRefBlock* weak_block;
+};
+
+
+/// Weak reference to WeakObject<T> - derived class.
+/**
+ *	Does not keep object alive. After object is released Lock() returns
+ *	NULL reference.
+ */
+template<class T>
+class WeakRef
+{
+public:
+
+	/// Default constructor.
+	inline WeakRef() { block = NULL; }
+
+	/// Copy constructor.
+	inline WeakRef( const WeakRef<T> & src )
+	{
+		block = src.block;
+		if( block )
+			block->weak_count++;
+	}
+
+	/// Construct from object reference.
+	/**
+	 *	@param src - referenced object or NULL reference.
+	 */
+	inline WeakRef( ObjRef<T> src )
+	{
+		T* p = src;
+		block = p ? p->AcquireWeakBlock() : NULL;
+	}
+
+	/// Destructor.
+	inline ~WeakRef() { Reset(); }
+
+	/// Assignment operator.
+	WeakRef & operator = ( const WeakRef<T> & src )
+	{
+		if( block != src.block )
+		{
+			Reset();
+			block = src.block;
+			if( block )
+				block->weak_count++;
+		}
+		return *this;
+	}
+
+	/// Assignment from object reference.
+	WeakRef & operator = ( ObjRef<T> src )
+	{
+		T* p = src;
+		WeakRefBlock* b = p ? p->AcquireWeakBlock() : NULL;
+		Reset();
+		block = b;
+		return *this;
+	}
+
+	/// Returns object reference, NULL if object is released.
+	inline ObjRef<T> Lock() const { return ObjRef<T>( Get() ); }
+
+	/// Returns plain pointer, NULL if object is released.
+	/**
+	 *	Pointer is valid only while somebody else keeps object alive.
+	 */
+	inline T* Get() const
+	{
+		return block && block->object && block->object->GetRefCount() ? static_cast<T*>( block->object ) : NULL;
+	}
+
+	/// Checks if object is released or reference is empty.
+	inline Bool IsExpired() const { return !Get(); }
+
+	/// Makes reference empty.
+	void Reset()
+	{
+		if( block && --block->weak_count == 0 && !block->object )
+			delete block;
+		block = NULL;
+	}
+
+private:
+	WeakRefBlock* block;
+};
+
+
+/// ObjRef<T> holds only object pointer, vector growth moves it without AddRef() and Release().
+template<class T>
+struct is_relocatable< ObjRef<T> >
+{
+	enum { value = True };
+};
+
+/// WeakRef<T> holds only block pointer, so it is relocatable.
+template<class T>
+struct is_relocatable< WeakRef<T> >
+{
+	enum { value = True };
+};
+
+
 } //namespace mdragon
 
 #endif //__MD_OBJECT_H__ 
@@ -0,0 +1,244 @@
+/** \file
+ *	Graph of Object references for cycle detection. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_OBJGRAPH_H__
+#define __MD_OBJGRAPH_H__
+
+namespace mdragon
+{
+
+/// Graph of references between Objects.
+/**
+ *	Built by caller, Object does not know objects it references. Add
+ *	references of objects to check, for example by AddRoomReferences(),
+ *	then FindCycles() splits graph into strongly connected components.
+ *	Every component of several objects, or object referencing itself, is
+ *	a cycle never released by reference counting.
+ */
+class ObjectGraph
+{
+public:
+
+	/// Removes all objects and references.
+	void Clear()
+	{
+		index.clear();
+		objects.clear();
+		visited.clear();
+		edges.clear();
+		cycle_start.clear();
+		cycle_objects.clear();
+	}
+
+	/// Adds object to graph.
+	/**
+	 *	@param o - object.
+	 *	@return Returns object index in graph.
+	 */
+	Int Add( Object* o )
+	{
+		Int* i = index.get( o );
+		if( i )
+			return *i;
+
+		index.insert( o, objects.size() );
+		objects.push_back( o );
+		visited.push_back( 0 );
+		return objects.size() - 1;
+	}
+
+	/// Marks object as walked, see AddRoomReferences().
+	/**
+	 *	@param o - object.
+	 *	@return Returns False if object was marked before.
+	 */
+	Bool Visit( Object* o )
+	{
+		Int i = Add( o );
+		if( visited[i] )
+			return False;
+
+		visited[i] = 1;
+		return True;
+	}
+
+	/// Checks if object is in graph.
+	inline Bool Contains( Object* o ) { return index.count( o ) != 0; }
+
+	/// Adds reference, NULL target is ignored.
+	/**
+	 *	@param from - referencing object.
+	 *	@param to - referenced object.
+	 */
+	void AddReference( Object* from, Object* to )
+	{
+		Int f = Add( from );
+		if( to )
+			edges.push_back( make_pair( f, Add( to ) ) );
+	}
+
+	/// Adds reference held by ObjRef.
+	template<class T>
+	inline void AddReference( Object* from, ObjRef<T>& to )
+	{
+		T* p = to;
+		AddReference( from, p );
+	}
+
+	/// Adds references held by ObjRef list.
+	template<class T>
+	void AddReferences( Object* from, vector< ObjRef<T> >& list )
+	{
+		Add( from );
+		for( Int i = 0; i < (Int)list.size(); i++ )
+			AddReference( from, list[i] );
+	}
+
+	/// Returns number of objects in graph.
+	inline Int GetObjectCount() { return objects.size(); }
+
+	/// Returns object by index.
+	inline Object* GetObject( Int i ) { return objects[i]; }
+
+	/// Finds reference cycles.
+	/**
+	 *	Runs Tarjan algorithm without recursion.
+	 *	@return Returns number of cycles found.
+	 */
+	Int FindCycles()
+	{
+		cycle_start.clear();
+		cycle_objects.clear();
+
+		Int n = objects.size();
+
+		// References grouped by referencing object.
+		vector<Int> edge_start( n + 1, 0 );
+		vector<Int> targets( edges.size(), 0 );
+
+		for( Int e = 0; e < (Int)edges.size(); e++ )
+			edge_start[ edges[e].first + 1 ]++;
+		for( Int i = 0; i < n; i++ )
+			edge_start[i + 1] += edge_start[i];
+
+		vector<Int> slot( edge_start );
+		for( Int e = 0; e < (Int)edges.size(); e++ )
+			targets[ slot[ edges[e].first ]++ ] = edges[e].second;
+
+		vector<Int> order( n, -1 ), low( n, 0 ), next_edge( n, 0 );
+		vector<Int> stack, path;
+		vector<Byte> on_stack( n, 0 );
+		Int counter = 0;
+
+		for( Int root = 0; root < n; root++ )
+		{
+			if( order[root] >= 0 )
+				continue;
+
+			path.push_back( root );
+
+			while( path.size() )
+			{
+				Int v = path[ path.size() - 1 ];
+
+				if( order[v] < 0 )
+				{
+					order[v] = low[v] = counter++;
+					next_edge[v] = edge_start[v];
+					stack.push_back( v );
+					on_stack[v] = 1;
+				}
+
+				if( next_edge[v] < edge_start[v+1] )
+				{
+					Int w = targets[ next_edge[v]++ ];
+
+					if( order[w] < 0 )
+						path.push_back( w );
+					else
+					if( on_stack[w] && order[w] < low[v] )
+						low[v] = order[w];
+
+					continue;
+				}
+
+				path.pop_back();
+
+				if( path.size() && low[v] < low[ path[ path.size() - 1 ] ] )
+					low[ path[ path.size() - 1 ] ] = low[v];
+
+				if( low[v] != order[v] )
+					continue;
+
+				// v is root of component, pop it.
+				Int first = cycle_objects.size();
+				Bool self = False;
+				Int w;
+
+				do
+				{
+					w = stack[ stack.size() - 1 ];
+					stack.pop_back();
+					on_stack[w] = 0;
+					cycle_objects.push_back( w );
+
+					for( Int e = edge_start[w]; e < edge_start[w+1]; e++ )
+						if( targets[e] == w )
+							self = True;
+				}
+				while( w != v );
+
+				if( cycle_objects.size() - first > 1 || self )
+					cycle_start.push_back( first );
+				else
+					cycle_objects.resize( first );
+			}
+		}
+
+		return cycle_start.size();
+	}
+
+	/// Returns number of cycles found by last FindCycles().
+	inline Int GetCycleCount() { return cycle_start.size(); }
+
+	/// Returns number of objects in cycle.
+	inline Int GetCycleSize( Int c )
+	{
+		return ( c + 1 < (Int)cycle_start.size() ? cycle_start[c + 1] : cycle_objects.size() ) - cycle_start[c];
+	}
+
+	/// Returns object of cycle.
+	/**
+	 *	@param c - cycle index.
+	 *	@param i - object index in cycle, less than GetCycleSize().
+	 */
+	inline Object* GetCycleObject( Int c, Int i ) { return objects[ cycle_objects[ cycle_start[c] + i ] ]; }
+
+private:
+
+	/// Object indexes.
+	hash_map<Object*, Int> index;
+
+	/// Objects by index.
+	vector<Object*> objects;
+
+	/// Walked flags by object index.
+	vector<Byte> visited;
+
+	/// References as pairs of object indexes.
+	vector< pair<Int, Int> > edges;
+
+	/// First entry in cycle_objects of every cycle.
+	vector<Int> cycle_start;
+
+	/// Objects of cycles.
+	vector<Int> cycle_objects;
+};
+
+} //namespace mdragon
+
+#endif // __MD_OBJGRAPH_H__
@@ -0,0 +1,239 @@
+/** \file
+ *	Fixed size object pools. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_OBJPOOL_H__
+#define __MD_OBJPOOL_H__
+
+namespace mdragon
+{
+
+/// Default number of objects in one ObjectPool slab.
+#define ObjectPool_Slab_Objects 32
+
+#if defined(MD_OS_LINUX)
+#define MD_OBJECT_POOL_SIZE_T size_t
+#else
+#define MD_OBJECT_POOL_SIZE_T unsigned int
+#endif
+
+
+/// Free list allocator of equal size objects.
+/**
+ *	Memory is taken by malloc() in slabs of several objects and returned
+ *	to free list on Free(), so allocation cost is constant and objects of
+ *	one class stay close in memory. Slabs are freed only by Trim(). Requests
+ *	of other size, for example of derived classes, go directly to malloc().
+ *	All pools are linked in a list for reports, see GetFirst().
+ */
+class ObjectPool
+{
+public:
+
+	/// Constructor.
+	/**
+	 *	@param name_ - pool name for reports, usually class name.
+	 *	@param object_size_ - size of object in bytes.
+	 *	@param slab_objects_ - number of objects per slab.
+	 */
+	ObjectPool( const Char* name_, Int object_size_, Int slab_objects_ = ObjectPool_Slab_Objects )
+	{
+		name = name_;
+		object_size = ( object_size_ + sizeof(void*) - 1 ) & ~( (Int)sizeof(void*) - 1 );
+		slab_objects = slab_objects_;
+		free_list = NULL;
+		slabs = NULL;
+		slab_count = 0;
+		live_count = 0;
+		peak_count = 0;
+		total_count = 0;
+
+		next = First();
+		First() = this;
+	}
+
+	/// Destructor. Frees slabs if no objects are alive.
+	~ObjectPool()
+	{
+		Trim();
+
+		for( ObjectPool** p = &First(); *p; p = &(*p)->next )
+			if( *p == this )
+			{
+				*p = next;
+				break;
+			}
+	}
+
+	/// Allocates object memory.
+	/**
+	 *	@param size - requested size, objects of other size than pool's are allocated by malloc().
+	 *	@return Returns pointer to memory, or NULL if out of memory.
+	 */
+	void* Alloc( MD_OBJECT_POOL_SIZE_T size )
+	{
+		if( (Int)size > object_size || (Int)size + (Int)sizeof(void*) <= object_size )
+			return mdragon::malloc( (Int)size );
+
+		if( !free_list && !AddSlab() )
+			return NULL;
+
+		Node* n = free_list;
+		free_list = n->next;
+
+		total_count++;
+		if( ++live_count > peak_count )
+			peak_count = live_count;
+
+		return n;
+	}
+
+	/// Frees object memory.
+	/**
+	 *	@param p - pointer returned by Alloc().
+	 *	@param size - the same size as passed to Alloc().
+	 */
+	void Free( void* p, MD_OBJECT_POOL_SIZE_T size )
+	{
+		if( !p )
+			return;
+
+		if( (Int)size > object_size || (Int)size + (Int)sizeof(void*) <= object_size )
+		{
+			mdragon::free( p );
+			return;
+		}
+
+		Node* n = (Node*)p;
+		n->next = free_list;
+		free_list = n;
+		live_count--;
+	}
+
+	/// Frees all slabs if no objects are alive.
+	/**
+	 *	@return Returns True if slabs were freed.
+	 */
+	Bool Trim()
+	{
+		if( live_count )
+			return False;
+
+		while( slabs )
+		{
+			Node* n = slabs->next;
+			mdragon::free( slabs );
+			slabs = n;
+		}
+
+		free_list = NULL;
+		slab_count = 0;
+		return True;
+	}
+
+	/// Returns pool name.
+	inline const Char* GetName() { return name; }
+
+	/// Returns size of pooled object in bytes.
+	inline Int GetObjectSize() { return object_size; }
+
+	/// Returns number of allocated objects.
+	inline Int GetLiveCount() { return live_count; }
+
+	/// Returns maximal number of allocated objects.
+	inline Int GetPeakCount() { return peak_count; }
+
+	/// Returns number of Alloc() calls served by pool.
+	inline Int GetTotalCount() { return total_count; }
+
+	/// Returns number of slabs.
+	inline Int GetSlabCount() { return slab_count; }
+
+	/// Returns first pool in list of all pools.
+	static inline ObjectPool* GetFirst() { return First(); }
+
+	/// Returns next pool in list of all pools.
+	inline ObjectPool* GetNext() { return next; }
+
+private:
+
+	/// Free object or slab header.
+	struct Node
+	{
+		Node* next;
+	};
+
+	Bool AddSlab()
+	{
+		// Slab header takes first object place, so memory stays aligned.
+		Node* slab = (Node*)mdragon::malloc( object_size * ( slab_objects + 1 ) );
+		if( !slab )
+			return False;
+
+		slab->next = slabs;
+		slabs = slab;
+		slab_count++;
+
+		Byte* p = (Byte*)slab + object_size * slab_objects;
+		for( Int i = 0; i < slab_objects; i++, p -= object_size )
+		{
+			Node* n = (Node*)p;
+			n->next = free_list;
+			free_list = n;
+		}
+
+		return True;
+	}
+
+	static inline ObjectPool*& First()
+	{
+		static ObjectPool* first = NULL;
+		return first;
+	}
+
+	ObjectPool( const ObjectPool& );
+	ObjectPool& operator = ( const ObjectPool& );
+
+	const Char* name;
+	Int object_size;
+	Int slab_objects;
+
+	Node* free_list;
+	Node* slabs;
+	Int slab_count;
+
+	Int live_count;
+	Int peak_count;
+	Int total_count;
+
+	ObjectPool* next;
+};
+
+
+/// Makes New() and Release() of class use ObjectPool.
+/**
+ *	Place in public section of class. Adds class operators new and delete
+ *	and static GetObjectPool(). Derived classes without own
+ *	MD_OBJECT_POOL are allocated by malloc(). Define MD_NO_OBJECT_POOLS
+ *	in project settings to use default operators.
+ *	Use only for classes created and deleted by header code: plain classes
+ *	like WeakRefBlock, or classes whose virtual destructor is defined in
+ *	header, so vtable and operator delete call are emitted there. Engine
+ *	classes like Basic3D or VertexBuffer are created and destroyed inside
+ *	engine library by global operators and must not be pooled.
+ */
+#ifndef MD_NO_OBJECT_POOLS
+#define MD_OBJECT_POOL(Class) \
+	static void* operator new( MD_OBJECT_POOL_SIZE_T size ) throw() { return GetObjectPool().Alloc( size ); } \
+	static void operator delete( void* p, MD_OBJECT_POOL_SIZE_T size ) { GetObjectPool().Free( p, size ); } \
+	static mdragon::ObjectPool& GetObjectPool() { static mdragon::ObjectPool pool( #Class, sizeof(Class) ); return pool; }
+#else
+#define MD_OBJECT_POOL(Class)
+#endif
+
+} //namespace mdragon
+
+#endif // __MD_OBJPOOL_H__
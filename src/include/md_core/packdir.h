@@ -8,6 +8,13 @@
 #ifndef __MD_PACKDIR_H__
 #define __MD_PACKDIR_H__
 
+#if defined(MD_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace mdragon
 {
 
@@ -115,6 +122,434 @@ public:
 	void* file_io;
 #endif
 
+#if defined(MD_OS_LINUX)
+	void* PackDirHandle; // FILE*
+#endif
+
+};
+
+
+/// Entry of pack directory file allocation table.
+class PackDirMapEntry
+{
+public:
+
+	/// Unpacked file size.
+	DWord size;
+
+	/// Size of file data in pack, equal to size if file is stored unpacked.
+	DWord packed_size;
+
+	/// Offset of file data in pack.
+	DWord offset;
+
+	/// File name, points to table data.
+	const Char* name;
+};
+
+
+/// Read-only memory mapping of packed directory image.
+/**
+ *	Kept beside PackDir, which is left unchanged. Reads file allocation
+ *	table, indexes it by name hash and maps data file to memory, so files
+ *	stored unpacked are viewed in place, see ViewFile(). The packdir tool
+ *	compresses every file it packs, so ViewFile() fails on packs it writes
+ *	and those files are still decompressed by PackDir. <br>
+ *	Texture, MDMLoad and GameData take Resource, use LoadFile() for them:
+ *	it copies stored files once from the mapping instead of reading the
+ *	data file, and falls back to PackDir for packed files.
+ *	Table entries are matched to PackDir items by PackDir::FindItem()
+ *	once in Open(), so all functions take and return PackDir item
+ *	indexes. Mapping is available on Linux only, elsewhere Open() fails
+ *	and lookups and loading are done by PackDir.
+ *	Table format is sequence of entries: DWord size, DWord packed size,
+ *	DWord offset, zero terminated name.
+ */
+class PackDirMapping
+{
+public:
+
+	/// Constructor.
+	PackDirMapping()
+	{
+		pack = NULL;
+		data = NULL;
+		data_size = 0;
+	}
+
+	/// Destructor, unmaps data.
+	~PackDirMapping()
+	{
+		Close();
+	}
+
+	/// Reads table of pack and maps its data file.
+	/**
+	 *	@param pack_ - pack directory, must exist while mapping is used.
+	 *	@return Returns True if table is read, see IsMapped() for data.
+	 */
+	Bool Open( PackDir& pack_ )
+	{
+		Close();
+		pack = &pack_;
+
+#if defined(MD_OS_LINUX)
+		string path( pack->GetName() );
+		path += ".fat";
+
+		if( !ReadFile( path.c_str(), fat ) || !ParseTable() )
+		{
+			Close();
+			return False;
+		}
+
+		path = pack->GetName();
+		path += ".dat";
+
+		int fd = ::open( path.c_str(), O_RDONLY );
+		if( fd < 0 )
+			return True;
+
+		struct stat st;
+		void* p = MAP_FAILED;
+
+		if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+			p = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+		::close( fd );
+
+		if( p == MAP_FAILED )
+			return True;
+
+		data = (const Byte*)p;
+		data_size = (Int)st.st_size;
+
+		// Entries outside of file are not mapped.
+		for( Int i = 0; i < (Int)entries.size(); i++ )
+			if( entries[i].offset + entries[i].packed_size > (DWord)data_size )
+				entries[i].packed_size = 0;
+
+		return True;
+#else
+		return False;
+#endif
+	}
+
+	/// Unmaps data and frees table, PackDir is kept for loading.
+	void Close()
+	{
+#if defined(MD_OS_LINUX)
+		if( data )
+			munmap( (void*)data, data_size );
+#endif
+		data = NULL;
+		data_size = 0;
+		index.clear();
+		entries.clear();
+		fat.clear();
+	}
+
+	/// Returns True if table is read.
+	inline Bool IsOpen() { return entries.size() != 0; }
+
+	/// Returns True if data file is mapped.
+	inline Bool IsMapped() { return data != NULL; }
+
+	/// Returns mapped data file, NULL if not mapped.
+	inline const Byte* GetData() { return data; }
+
+	/// Returns pack given to Open().
+	inline PackDir* GetPackDir() { return pack; }
+
+	/// Returns table entry of file.
+	/**
+	 *	@param item - index of file in PackDir.
+	 *	@return Returns entry, or NULL if table has no entry for file.
+	 */
+	inline const PackDirMapEntry* GetEntry( Int item )
+	{
+		if( item < 0 || item >= (Int)entries.size() || !entries[item].name )
+			return NULL;
+
+		return &entries[item];
+	}
+
+	/// Finds file by name in hash index of file allocation table.
+	/**
+	 *	@return Returns index of file in PackDir, or -1 if table has no entry for file.
+	 */
+	Int FindEntry( const Char* name )
+	{
+		Int* i = index.get( name );
+		return i ? *i : -1;
+	}
+
+	/// Finds file by name in hash index of file allocation table.
+	/**
+	 *	If table is not read, and for files not found, works as PackDir::FindItem().
+	 *	@param name - pointer to file ASCII name. Use only lowercase string. 
+	 *	@param log_not_found - if True will write message to sytem log if specified file not found.
+	 *	@return index of found specified file. If file not found return -1.
+	 */
+	Int LookupItem( const Char* name, Bool log_not_found = True )
+	{
+		Int item = FindEntry( name );
+		if( item >= 0 )
+			return item;
+
+		return pack ? pack->FindItem( name, log_not_found ) : -1;
+	}
+
+	/// Asks system to read data range ahead, so following access does not wait.
+	/**
+	 *	@param offset - offset in data file.
+	 *	@param size - size of range in bytes.
+	 */
+	void Prefetch( DWord offset, DWord size )
+	{
+#if defined(MD_OS_LINUX)
+		if( !data || offset >= (DWord)data_size )
+			return;
+
+		if( size > (DWord)data_size - offset )
+			size = (DWord)data_size - offset;
+
+		DWord page = (DWord)sysconf( _SC_PAGESIZE );
+		DWord start = offset - offset % page;
+
+		madvise( (void*)( data + start ), size + ( offset - start ), MADV_WILLNEED );
+#endif
+	}
+
+	/// Returns mapped data of file stored unpacked.
+	/**
+	 *	@param item - index of file in PackDir.
+	 *	@return Returns pointer to file data, or NULL if file is packed or pack is not mapped.
+	 */
+	const Byte* GetStoredData( Int item )
+	{
+		const PackDirMapEntry* e = GetEntry( item );
+		if( !data || !e || !e->packed_size || e->size != e->packed_size )
+			return NULL;
+
+		return data + e->offset;
+	}
+
+	/// Makes view of file stored unpacked in mapped pack.
+	/**
+	 *	File is not copied, view is valid while mapping is open.
+	 *	@param name - name of file.
+	 *	@param view - receives view of file data.
+	 *	@return Return False if file is not found, is packed or pack is
+	 *	not mapped, load it by PackDir::LoadFile() then.
+	 */
+	Bool ViewFile( const Char * name, ResourceView & view )
+	{
+		Int item = FindEntry( name );
+		return item >= 0 && ViewItem( item, view );
+	}
+
+	/// Makes view of file stored unpacked in mapped pack.
+	/**
+	 *	See ViewFile().
+	 *	@param item - index of file in PackDir.
+	 *	@param view - receives view of file data.
+	 *	@return Return False if file is packed or pack is not mapped.
+	 */
+	Bool ViewItem( Int item, ResourceView & view )
+	{
+		const Byte* p = GetStoredData( item );
+		if( !p )
+			return False;
+
+		view.Set( p, GetEntry( item )->size );
+		return True;
+	}
+
+	/// Loads file into Resource for loaders taking Resource.
+	/**
+	 *	@param name - name of file.
+	 *	@param resource - receives file data, read position is set to 0.
+	 *	@return Returns True if file is loaded.
+	 */
+	Bool LoadFile( const Char * name, Resource & resource )
+	{
+		Int item = LookupItem( name );
+		return item >= 0 && LoadItem( item, resource );
+	}
+
+	/// Loads file into Resource for loaders taking Resource.
+	/**
+	 *	Files stored unpacked are copied from mapped pack, others are
+	 *	loaded by PackDir::LoadItem().
+	 *	@param item - index of file in PackDir.
+	 *	@param resource - receives file data, read position is set to 0.
+	 *	@return Returns True if file is loaded.
+	 */
+	Bool LoadItem( Int item, Resource & resource )
+	{
+		const Byte* p = GetStoredData( item );
+		if( !p )
+			return pack && pack->LoadItem( item, resource );
+
+		Int size = (Int)GetEntry( item )->size;
+		resource.Resize( size );
+		memcpy( resource.GetData(), p, size );
+		resource.SetPosition( 0 );
+		return True;
+	}
+
+	/// Loads several files by LoadItem().
+	/**
+	 *	This is not batched I/O: every packed file is still one seek and
+	 *	read by PackDir::LoadItem(). On Linux, where table is read, requests
+	 *	are sorted by file offset in pack, so reads only move forward, and
+	 *	mapped range they cover is prefetched before loading. On other
+	 *	platforms files are loaded one by one in order of names.
+	 *	@param names - file names.
+	 *	@param count - number of files.
+	 *	@param resources - array of count Resource objects, receives files in order of names.
+	 *	@return Returns number of files loaded, files not found are logged and skipped.
+	 */
+	Int LoadFiles( const Char* const* names, Int count, Resource* resources )
+	{
+		if( !pack )
+			return 0;
+
+		vector< pair<DWord, Int> > order;
+		vector<Int> items( count, -1 );
+		order.reserve( count );
+
+		// Files without table entry are loaded last.
+		for( Int i = 0; i < count; i++ )
+		{
+			items[i] = LookupItem( names[i] );
+			if( items[i] >= 0 )
+			{
+				const PackDirMapEntry* e = GetEntry( items[i] );
+				order.push_back( make_pair( e ? e->offset : (DWord)0xFFFFFFFF, i ) );
+			}
+		}
+
+		if( IsOpen() && order.size() )
+		{
+			sort( order.begin(), order.end() );
+
+			DWord first = order[0].first;
+			DWord end = first;
+
+			for( Int i = 0; i < (Int)order.size() && order[i].first != (DWord)0xFFFFFFFF; i++ )
+			{
+				const PackDirMapEntry* e = GetEntry( items[ order[i].second ] );
+				end = max( end, e->offset + e->packed_size );
+			}
+
+			if( end > first )
+				Prefetch( first, end - first );
+		}
+
+		Int loaded = 0;
+		for( Int i = 0; i < (Int)order.size(); i++ )
+		{
+			Int request = order[i].second;
+			if( LoadItem( items[request], resources[request] ) )
+				loaded++;
+		}
+
+		return loaded;
+	}
+
+private:
+
+#if defined(MD_OS_LINUX)
+	static Bool ReadFile( const Char* path, vector<Byte>& buffer )
+	{
+		int fd = ::open( path, O_RDONLY );
+		if( fd < 0 )
+			return False;
+
+		struct stat st;
+		Bool ok = fstat( fd, &st ) == 0;
+
+		if( ok )
+		{
+			// Terminating zero guards the last name.
+			buffer.resize( (Int)st.st_size + 1 );
+			ok = ::read( fd, buffer.begin(), (size_t)st.st_size ) == (ssize_t)st.st_size;
+			buffer[ buffer.size() - 1 ] = 0;
+		}
+
+		::close( fd );
+		return ok;
+	}
+#endif
+
+	/// Reads table and places entries at PackDir item indexes.
+	Bool ParseTable()
+	{
+		Int end = fat.size() - 1;
+		Int pos = 0;
+
+		vector<PackDirMapEntry> table;
+
+		while( pos + 12 < end )
+		{
+			PackDirMapEntry e;
+			memcpy( &e.size, fat.begin() + pos, 4 );
+			memcpy( &e.packed_size, fat.begin() + pos + 4, 4 );
+			memcpy( &e.offset, fat.begin() + pos + 8, 4 );
+			e.name = (const Char*)fat.begin() + pos + 12;
+
+			pos += 12 + strlen( e.name ) + 1;
+			if( pos > end )
+				return False;
+
+			table.push_back( e );
+		}
+
+		if( pos != end || !table.size() )
+			return False;
+
+		PackDirMapEntry none;
+		none.size = 0;
+		none.packed_size = 0;
+		none.offset = 0;
+		none.name = NULL;
+
+		index.reserve( table.size() );
+
+		for( Int i = 0; i < (Int)table.size(); i++ )
+		{
+			Int item = pack->FindItem( table[i].name, False );
+			if( item < 0 )
+				continue;
+
+			if( item >= (Int)entries.size() )
+				entries.resize( item + 1, none );
+
+			entries[item] = table[i];
+			index.insert( table[i].name, item );
+		}
+
+		return entries.size() != 0;
+	}
+
+	PackDirMapping( const PackDirMapping& );
+	PackDirMapping& operator = ( const PackDirMapping& );
+
+	PackDir* pack;
+
+	/// Table file data, entry names point to it.
+	vector<Byte> fat;
+
+	/// Table entries at PackDir item indexes, name is NULL for items without entry.
+	vector<PackDirMapEntry> entries;
+
+	/// PackDir item indexes by name.
+	hash_map<const Char*, Int> index;
+
+	const Byte* data;
+	Int data_size;
 };
 
 } //namespace mdragon
@@ -0,0 +1,95 @@
+/** \file
+ *	Reader of packed directory files. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_PACKREADER_H__
+#define __MD_PACKREADER_H__
+
+namespace mdragon
+{
+
+/// Reader of file in PackDir.
+/**
+ *	Reads as ResourceView. Files stored unpacked are viewed directly in
+ *	memory mapped pack without copying. Packed files, and all files where
+ *	pack is not mapped, are loaded as whole by PackDir::LoadItem() and
+ *	viewed in memory of reader. Decompression of packed files is done by
+ *	PackDir, it is not done in chunks, so reader does not lower peak
+ *	memory for them.
+ */
+class PackDirReader : public ResourceView
+{
+public:
+
+	/// Constructor.
+	PackDirReader() { ; }
+
+	/// Destructor.
+	~PackDirReader()
+	{
+		Close();
+	}
+
+	/// Opens file by name.
+	/**
+	 *	@param m - mapping opened for pack, must stay open while file is read.
+	 *	@param name - file name.
+	 *	@return Returns True if file is opened.
+	 */
+	Bool Open( PackDirMapping& m, const Char* name )
+	{
+		Int item = m.LookupItem( name );
+		return item >= 0 && Open( m, item );
+	}
+
+	/// Opens file by index.
+	/**
+	 *	@param m - mapping opened for pack, must stay open while file is read.
+	 *	@param item - index of file in pack.
+	 *	@return Returns True if file is opened.
+	 */
+	Bool Open( PackDirMapping& m, Int item )
+	{
+		Close();
+
+		if( !m.GetPackDir() )
+			return False;
+
+		if( m.ViewItem( item, *this ) )
+			return True;
+
+		if( !m.GetPackDir()->LoadItem( item, whole ) )
+			return False;
+
+		Set( whole.GetData(), whole.Size() );
+		return True;
+	}
+
+	/// Closes file.
+	void Close()
+	{
+		whole.Clear();
+		Clear();
+	}
+
+	/// Returns True if file is read from mapped pack without copying.
+	inline Bool IsMapped() { return GetData() && !whole.Size(); }
+
+	/// Returns True if whole file is read.
+	inline Bool IsEnd() { return GetPosition() >= Size(); }
+
+private:
+
+	PackDirReader( const PackDirReader& );
+	PackDirReader& operator = ( const PackDirReader& );
+
+	/// File loaded as whole.
+	Resource whole;
+};
+
+} //namespace mdragon
+
+#endif // __MD_PACKREADER_H__
@@ -204,7 +204,7 @@ public:
 		Int data_size = sizeof(POD);
 
 		if(position + data_size * size > Size() )
-			resource.Resize( position + data_size * size );
+			resource.resize( position + data_size * size );
 
 		for( Int i = 0; i < size; i++, d++, position += data_size )
 			memcpy( &resource[position], d, data_size );
@@ -333,6 +333,148 @@ private:
 	string name;
 };
 
+
+/// Read-only view of binary data owned by someone else.
+/**
+ *	Reads data the same way as Resource, but does not copy it. Used for
+ *	files stored unpacked in memory mapped pack, see PackDirMapping::ViewFile().
+ *	Data must stay valid while view is used.
+ */
+class ResourceView
+{
+
+public:
+
+	/// Default constructor. Creates empty view.
+	ResourceView()
+	{
+		data = NULL;
+		data_size = 0;
+		position = 0;
+	}
+
+
+	/// Makes view of memory and sets read position to 0.
+	/**
+	 *	@param data_ - pointer to data.
+	 *	@param size_ - data size in bytes.
+	 */
+	inline void Set( const Byte* data_, Int size_ )
+	{
+		data = data_;
+		data_size = size_;
+		position = 0;
+	}
+
+
+	/// Makes view empty.
+	inline void Clear() { Set( NULL, 0 ); }
+
+
+	/// Returns pointer to viewed data.
+	inline const Byte* GetData() { return data; }
+
+
+	/// Returns size of viewed data.
+	inline Int Size() { return data_size; }
+
+
+	/// Returns current read position.
+	inline Int GetPosition() { return position; }
+
+
+	/// Sets read position.
+	/**
+	 *	@param position_ - new read position.
+	 *	@return old read position.
+	 */
+	inline Int SetPosition( Int position_ )
+	{
+		Int old = position;
+		position = position_;
+		return old;
+	}
+
+
+	/// Moves read position further, stops at end of data.
+	/**
+	 *	@param skip - number of bytes to move read position.
+	 *	@return new read position.
+	 */
+	inline Int Skip( Int skip )
+	{
+		position = min( position + skip, data_size );
+		return position;
+	}
+
+
+	/// Reads one POD object.
+	/**
+	 *	@param d - pointer to POD object.
+	 *	@return True if read complete successfully else False.
+	 */
+	template <class POD> 
+	Bool Read( POD* d )
+	{
+		return Read( (Byte*)d, (Int)sizeof( POD ) );
+	}
+
+
+	/// Reads specified number of POD objects.
+	/**
+	 *	@param d - pointer to POD objects array.
+	 *	@param size - number of POD objects to read.
+	 *	@return True if read complete successfully else False.
+	 */
+	template <class POD> 
+	Bool Read( POD* d, Int size )
+	{
+		return Read( (Byte*)d, (Int)sizeof( POD ) * size );
+	}
+
+
+	/// Reads specified number of characters.
+	inline Bool Read( Char* d, Int size ) { return Read( (Byte*)d, size ); }
+
+
+	/// Reads specified number of bytes.
+	/**
+	 *	@param d - pointer to buffer.
+	 *	@param size - number of bytes to read.
+	 *	@return True if read complete successfully else False.
+	 */
+	Bool Read( Byte* d, Int size )
+	{
+		if( size >= 0 && position + size <= data_size )
+		{
+			memcpy( d, data + position, size );
+			position += size;
+			return True;
+		}
+		return False;
+	}
+
+
+	/// Reads one Float stored as 16.16 fixed, see Resource::ReadFloat().
+	Bool ReadFloat( Float* d )
+	{
+		Int fixed;
+		if( !Read( &fixed ) )
+			return False;
+
+		*d = Float( fixed ) / 65536;
+		return True;
+	}
+
+private:
+
+	const Byte* data;
+
+	Int data_size;
+
+	Int position;
+};
+
 #if defined(MD_OS_SYMBIAN_S60) || defined(MD_OS_SYMBIAN_UIQ)
 
 template <class T>
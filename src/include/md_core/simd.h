@@ -0,0 +1,240 @@
+/** \file
+ *	Integer SIMD operations for batch kernels. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_SIMD_H__
+#define __MD_SIMD_H__
+
+/*
+ *	Instruction set is selected at compile time. Define MD_NO_SIMD in
+ *	project settings to use scalar code only.
+ */
+#if !defined(MD_NO_SIMD)
+#if defined(__AVX2__)
+#define MD_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define MD_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MD_SIMD_NEON
+#endif
+#endif
+
+#if defined(MD_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(MD_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(MD_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace mdragon
+{
+
+/// Scalar implementation of SIMD operations, one lane.
+/**
+ *	Every SimdXXX class has the same set of static functions working on
+ *	Width lanes of 32 bit integers, so batch kernels are written once as
+ *	templates and give bit-identical results with any of them.
+ *	Masks returned by comparisons have all bits of lane set or cleared.
+ */
+struct SimdScalar
+{
+	typedef Int V;
+
+	enum { Width = 1 };
+
+	static inline V Load( const Int* p ) { return *p; }
+	static inline void Store( Int* p, V a ) { *p = a; }
+	static inline V Set( Int a ) { return a; }
+
+	static inline V Add( V a, V b ) { return a + b; }
+	static inline V Sub( V a, V b ) { return a - b; }
+	static inline V And( V a, V b ) { return a & b; }
+	static inline V Or( V a, V b ) { return a | b; }
+
+	/// Arithmetic shift right.
+	static inline V Sra( V a, Int n ) { return a >> n; }
+
+	/// Low 32 bits of product.
+	static inline V MulLo( V a, V b ) { return a * b; }
+
+	/// 16.16 fixed point product, same as FixedMul().
+	static inline V MulFixed( V a, V b ) { return FixedMul( a, b ); }
+
+	/// (1<<30) / a, a must be positive.
+	static inline V Recip30( V a ) { return ( 1 << 30 ) / a; }
+
+	/// Returns mask of lanes where a > b.
+	static inline V CmpGt( V a, V b ) { return a > b ? -1 : 0; }
+
+	/// Returns a in lanes set in mask, b in others.
+	static inline V Select( V mask, V a, V b ) { return ( a & mask ) | ( b & ~mask ); }
+};
+
+
+#if defined(MD_SIMD_SSE2) || defined(MD_SIMD_AVX2)
+
+/// SSE2 implementation of SIMD operations, 4 lanes.
+struct SimdSSE2
+{
+	typedef __m128i V;
+
+	enum { Width = 4 };
+
+	static inline V Load( const Int* p ) { return _mm_loadu_si128( (const __m128i*)p ); }
+	static inline void Store( Int* p, V a ) { _mm_storeu_si128( (__m128i*)p, a ); }
+	static inline V Set( Int a ) { return _mm_set1_epi32( a ); }
+
+	static inline V Add( V a, V b ) { return _mm_add_epi32( a, b ); }
+	static inline V Sub( V a, V b ) { return _mm_sub_epi32( a, b ); }
+	static inline V And( V a, V b ) { return _mm_and_si128( a, b ); }
+	static inline V Or( V a, V b ) { return _mm_or_si128( a, b ); }
+
+	static inline V Sra( V a, Int n ) { return _mm_sra_epi32( a, _mm_cvtsi32_si128( n ) ); }
+
+	static inline V MulLo( V a, V b )
+	{
+		V even = _mm_mul_epu32( a, b );
+		V odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+		return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE(0,0,2,0) ),
+				_mm_shuffle_epi32( odd, _MM_SHUFFLE(0,0,2,0) ) );
+	}
+
+	static inline V MulFixed( V a, V b )
+	{
+		// Bits 16..47 of unsigned products, then signed correction of high word.
+		V even = _mm_srli_epi64( _mm_mul_epu32( a, b ), 16 );
+		V odd = _mm_srli_epi64( _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) ), 16 );
+		V r = _mm_or_si128( _mm_and_si128( even, _mm_set_epi32( 0, -1, 0, -1 ) ), _mm_slli_epi64( odd, 32 ) );
+		V c = _mm_add_epi32( _mm_and_si128( _mm_srai_epi32( a, 31 ), b ), _mm_and_si128( _mm_srai_epi32( b, 31 ), a ) );
+		return _mm_sub_epi32( r, _mm_slli_epi32( c, 16 ) );
+	}
+
+	static inline V Recip30( V a )
+	{
+		// Double quotient of 32 bit integers truncates to exact integer quotient.
+		__m128d n = _mm_set1_pd( 1073741824.0 );
+		V lo = _mm_cvttpd_epi32( _mm_div_pd( n, _mm_cvtepi32_pd( a ) ) );
+		V hi = _mm_cvttpd_epi32( _mm_div_pd( n, _mm_cvtepi32_pd( _mm_shuffle_epi32( a, _MM_SHUFFLE(1,0,3,2) ) ) ) );
+		return _mm_unpacklo_epi64( lo, hi );
+	}
+
+	static inline V CmpGt( V a, V b ) { return _mm_cmpgt_epi32( a, b ); }
+
+	static inline V Select( V mask, V a, V b ) { return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) ); }
+};
+
+#endif // MD_SIMD_SSE2
+
+
+#if defined(MD_SIMD_AVX2)
+
+/// AVX2 implementation of SIMD operations, 8 lanes.
+struct SimdAVX2
+{
+	typedef __m256i V;
+
+	enum { Width = 8 };
+
+	static inline V Load( const Int* p ) { return _mm256_loadu_si256( (const __m256i*)p ); }
+	static inline void Store( Int* p, V a ) { _mm256_storeu_si256( (__m256i*)p, a ); }
+	static inline V Set( Int a ) { return _mm256_set1_epi32( a ); }
+
+	static inline V Add( V a, V b ) { return _mm256_add_epi32( a, b ); }
+	static inline V Sub( V a, V b ) { return _mm256_sub_epi32( a, b ); }
+	static inline V And( V a, V b ) { return _mm256_and_si256( a, b ); }
+	static inline V Or( V a, V b ) { return _mm256_or_si256( a, b ); }
+
+	static inline V Sra( V a, Int n ) { return _mm256_sra_epi32( a, _mm_cvtsi32_si128( n ) ); }
+
+	static inline V MulLo( V a, V b ) { return _mm256_mullo_epi32( a, b ); }
+
+	static inline V MulFixed( V a, V b )
+	{
+		V even = _mm256_srli_epi64( _mm256_mul_epi32( a, b ), 16 );
+		V odd = _mm256_srli_epi64( _mm256_mul_epi32( _mm256_srli_epi64( a, 32 ), _mm256_srli_epi64( b, 32 ) ), 16 );
+		return _mm256_blend_epi32( even, _mm256_slli_epi64( odd, 32 ), 0xAA );
+	}
+
+	static inline V Recip30( V a )
+	{
+		__m256d n = _mm256_set1_pd( 1073741824.0 );
+		__m128i lo = _mm256_cvttpd_epi32( _mm256_div_pd( n, _mm256_cvtepi32_pd( _mm256_castsi256_si128( a ) ) ) );
+		__m128i hi = _mm256_cvttpd_epi32( _mm256_div_pd( n, _mm256_cvtepi32_pd( _mm256_extracti128_si256( a, 1 ) ) ) );
+		return _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), hi, 1 );
+	}
+
+	static inline V CmpGt( V a, V b ) { return _mm256_cmpgt_epi32( a, b ); }
+
+	static inline V Select( V mask, V a, V b ) { return _mm256_blendv_epi8( b, a, mask ); }
+};
+
+#endif // MD_SIMD_AVX2
+
+
+#if defined(MD_SIMD_NEON)
+
+/// NEON implementation of SIMD operations, 4 lanes.
+struct SimdNEON
+{
+	typedef int32x4_t V;
+
+	enum { Width = 4 };
+
+	static inline V Load( const Int* p ) { return vld1q_s32( (const int32_t*)p ); }
+	static inline void Store( Int* p, V a ) { vst1q_s32( (int32_t*)p, a ); }
+	static inline V Set( Int a ) { return vdupq_n_s32( a ); }
+
+	static inline V Add( V a, V b ) { return vaddq_s32( a, b ); }
+	static inline V Sub( V a, V b ) { return vsubq_s32( a, b ); }
+	static inline V And( V a, V b ) { return vandq_s32( a, b ); }
+	static inline V Or( V a, V b ) { return vorrq_s32( a, b ); }
+
+	static inline V Sra( V a, Int n ) { return vshlq_s32( a, vdupq_n_s32( -n ) ); }
+
+	static inline V MulLo( V a, V b ) { return vmulq_s32( a, b ); }
+
+	static inline V MulFixed( V a, V b )
+	{
+		int32x2_t lo = vshrn_n_s64( vmull_s32( vget_low_s32( a ), vget_low_s32( b ) ), 16 );
+		int32x2_t hi = vshrn_n_s64( vmull_s32( vget_high_s32( a ), vget_high_s32( b ) ), 16 );
+		return vcombine_s32( lo, hi );
+	}
+
+	static inline V Recip30( V a )
+	{
+		// No integer or portable double division in NEON.
+		Int t[4];
+		Store( t, a );
+		for( Int i = 0; i < 4; i++ )
+			t[i] = ( 1 << 30 ) / t[i];
+		return Load( t );
+	}
+
+	static inline V CmpGt( V a, V b ) { return vreinterpretq_s32_u32( vcgtq_s32( a, b ) ); }
+
+	static inline V Select( V mask, V a, V b ) { return vbslq_s32( vreinterpretq_u32_s32( mask ), a, b ); }
+};
+
+#endif // MD_SIMD_NEON
+
+
+#if defined(MD_SIMD_AVX2)
+#define MD_SIMD
+typedef SimdAVX2 SimdNative;
+#elif defined(MD_SIMD_SSE2)
+#define MD_SIMD
+typedef SimdSSE2 SimdNative;
+#elif defined(MD_SIMD_NEON)
+#define MD_SIMD
+typedef SimdNEON SimdNative;
+#else
+typedef SimdScalar SimdNative;
+#endif
+
+} //namespace mdragon
+
+#endif // __MD_SIMD_H__
@@ -13,6 +13,13 @@
 #include <e32std.h>
 #endif
 
+#if defined(MD_OS_LINUX)
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
 //#define Fixed float
 
 namespace mdragon
@@ -70,6 +77,23 @@ typedef Int Bool;
 
 #endif // MD_OS_PALM
 
+#ifdef MD_OS_LINUX
+
+typedef char Char;
+typedef unsigned char Byte;
+typedef short Short;
+typedef unsigned short Word;
+typedef int Int;
+typedef unsigned int DWord;
+typedef long long Long;
+typedef float Float;
+typedef double Double;
+typedef Int Bool;
+#define True (1>0)
+#define False (1<0)
+
+#endif // MD_OS_LINUX
+
 } // namespace mdragon
 
 #endif // __MD_TYPES_H__
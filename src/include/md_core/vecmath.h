@@ -2720,6 +2720,11 @@ Quaternion<Real> QuaternionFromMatrix ( const Matrix4<Real> & tm );
 template <class Real>
 Quaternion<Real> QuaternionSlerp ( Quaternion<Real> a, Quaternion<Real> b, Real fraction );
 
+template <class Real> struct is_relocatable< Vector2<Real> > { enum { value = True }; };
+template <class Real> struct is_relocatable< Vector3<Real> > { enum { value = True }; };
+template <class Real> struct is_relocatable< Vector4<Real> > { enum { value = True }; };
+template <class Real> struct is_relocatable< Quaternion<Real> > { enum { value = True }; };
+
 } //namespace mdragon
 
 #endif // __MD_VECMATH_H__
@@ -13,6 +13,7 @@ namespace mdragon
 
 class Actor3DAnimation;
 class Actor3DAnimationNode;
+class Actor3DAnimationIndex;
 
 /// 3d morphing animation object.
 /**
@@ -61,8 +62,22 @@ public:
 	}
 
 	/// Sends all Actor3D nodes to draw queue.
+	/**
+	 * Nodes are drawn by Actor3DNode::Draw(), which morphs node VBs in
+	 * Render3D::Draw() every frame, even if interpolation value did not
+	 * change. Use Draw(MorphCacheMap&) to keep morphing results.
+	 */
 	void Draw();
 
+	/// Sends all Actor3D nodes to draw queue using morphing caches.
+	/**
+	 * Actor3DNode nodes are drawn by Actor3DNode::Draw(MorphCache&) with
+	 * cache of the node from caches, other nodes by their Draw(). Nodes
+	 * must be forgotten in caches after Create() or Detach().
+	 * @param caches - caller owned morphing caches.
+	 */
+	inline void Draw(MorphCacheMap& caches);
+
 	/// Updates Actor3D and all nodes result transform matrix.
 	/**
 	 * Need to call after Actor3D matrix transform update. 
@@ -99,6 +114,24 @@ public:
 	 */ 
 	Bool Attach(ObjRef<Actor3DAnimation> a3danim, const Char* node_name);
 
+	/// Attaches specified node from Actor3DAnimation to the common model.
+	/**
+	 * Finds node by name id, see Actor3DAnimation::FindNode().
+	 * @param a3danim - pointer to Actor3DAnimation class object.
+	 * @param node_name - name of node to attach.
+	 * @return Returns True, if node was found and attached, else - False.
+	 */ 
+	Bool Attach(ObjRef<Actor3DAnimation> a3danim, const Name& node_name);
+
+	/// Attaches node found by name id in animation index.
+	/**
+	 * Compares name ids only, see Actor3DAnimationIndex.
+	 * @param index - index built for Actor3DAnimation object.
+	 * @param node_name - name of node to attach.
+	 * @return Returns True, if node was found and attached, else - False.
+	 */ 
+	Bool Attach(Actor3DAnimationIndex& index, const Name& node_name);
+
 	/// Attaches specified Actor3DAnimationNode node.
 	/**
 	 * @param a3danim_node_ - Actor3DAnimationNode class object.
@@ -246,8 +279,37 @@ public:
 	}
 
 	/// Sends node to draw queue.
+	/**
+	 * Node VBs are morphed by Render3D::Draw() on every call.
+	 */
 	void Draw();
 
+	/// Sends node to draw queue using morphing cache.
+	/**
+	 * Does the same as Draw(), but node is morphed by MorphCache into VB
+	 * drawn by Render3D::Draw(vb,clip), so it is not morphed again while
+	 * interpolation value and LOD VBs stay the same. Packed VBs can not be
+	 * morphed by MorphCache and are drawn as by Draw().
+	 * @param cache - caller owned morphing cache of this node, see MorphCacheMap.
+	 */
+	inline void Draw(MorphCache& cache);
+
+	/// Checks if node is drawn exactly at one key frame.
+	/**
+	 * @return Returns True if both morphing VBs are the same or 
+	 * interpolation value is 0 or 1, else - False.
+	 */
+	inline Bool IsKeyFrame() { return vb_0 == vb_1 || li <= F_ZERO || li >= F_ONE; }
+
+	/// Morphs node VBs with current interpolation value.
+	/**
+	 * Key frame VB is returned without morphing, see IsKeyFrame().
+	 * @param cache - caller owned morphing cache of this node, see MorphCacheMap.
+	 * @param normals - True to morph vertex normals too.
+	 * @return Returns morphed VB, or NULL if VBs can not be morphed.
+	 */
+	inline ObjRef<VertexBuffer> Morph(MorphCache& cache,Bool normals) { return cache.Morph( vb_0, vb_1, li, normals ); }
+
 	/// Updates node result transform matrix.
 	/**
 	 * Need to call after node matrix transform update. 
@@ -347,6 +409,9 @@ public:
 	 */
 	const string & GetName() { return name; }
 
+	/// Returns interned name id.
+	inline NameID GetNameID() { return NameTable::Instance().Intern( name.c_str() ); }
+
 	/// Material.
 	Material material;
 
@@ -413,6 +478,25 @@ public:
 	 */
 	inline const string & GetName() { return name; }
 
+	/// Returns interned name id.
+	inline NameID GetNameID() { return NameTable::Instance().Intern( name.c_str() ); }
+
+	/// Finds animation node by name.
+	/**
+	 * Compares name strings of all nodes. For repeated lookups build
+	 * Actor3DAnimationIndex once after loading.
+	 * @param name_ - node name.
+	 * @return Returns node, or NULL reference if not found.
+	 */
+	ObjRef<Actor3DAnimationNode> FindNode( const Name& name_ )
+	{
+		const string& s = name_.GetString();
+		for( Int i = 0; i < (Int)nodes.size(); i++ )
+			if( nodes[i]->GetName() == s )
+				return nodes[i];
+		return ObjRef<Actor3DAnimationNode>();
+	}
+
 	/// Returns pointer to Render3D object.
 	/**
 	 * @return Returns pointer to Render3D object.
@@ -420,6 +504,7 @@ public:
 	inline Render3D* GetRender() { return render; }
 
 	friend class Actor3D;
+	friend class Actor3DAnimationIndex;
 	friend class MDMLoad;
 	friend class Render3D;
 
@@ -439,6 +524,78 @@ protected:
 
 };
 
+
+/// Animation nodes by name id.
+/**
+ *	Build once for every loaded Actor3DAnimation, then FindNode() is one
+ *	integer hash lookup. Names of nodes are interned only by Build().
+ */
+class Actor3DAnimationIndex
+{
+public:
+
+	/// Builds index of all nodes of animation.
+	/**
+	 * If several nodes have same name, first of them is found.
+	 * @param a3danim_ - animation, NULL reference clears index.
+	 */
+	void Build( ObjRef<Actor3DAnimation> a3danim_ )
+	{
+		Clear();
+		a3danim = a3danim_;
+		if( a3danim == NULL )
+			return;
+
+		for( Int i = 0; i < (Int)a3danim->nodes.size(); i++ )
+		{
+			NameID id = a3danim->nodes[i]->GetNameID();
+			if( !nodes.count( id ) )
+				nodes.insert( id, a3danim->nodes[i] );
+		}
+	}
+
+	/// Removes all nodes and animation reference.
+	inline void Clear()
+	{
+		nodes.clear();
+		a3danim = NULL;
+	}
+
+	/// Returns indexed animation.
+	inline ObjRef<Actor3DAnimation> GetActor3DAnimation() { return a3danim; }
+
+	/// Finds animation node by name id.
+	/**
+	 * @param name_ - node name.
+	 * @return Returns node, or NULL reference if not found.
+	 */
+	ObjRef<Actor3DAnimationNode> FindNode( const Name& name_ )
+	{
+		ObjRef<Actor3DAnimationNode>* node = nodes.get( name_.GetID() );
+		return node ? *node : ObjRef<Actor3DAnimationNode>();
+	}
+
+private:
+
+	/// Indexed animation.
+	ObjRef<Actor3DAnimation> a3danim;
+
+	/// Nodes by name id.
+	hash_map< NameID, ObjRef<Actor3DAnimationNode> > nodes;
+};
+
+inline Bool Actor3D::Attach(ObjRef<Actor3DAnimation> a3danim, const Name& node_name)
+{
+	ObjRef<Actor3DAnimationNode> node = a3danim->FindNode( node_name );
+	return node != NULL ? Attach( node ) : False;
+}
+
+inline Bool Actor3D::Attach(Actor3DAnimationIndex& index, const Name& node_name)
+{
+	ObjRef<Actor3DAnimationNode> node = index.FindNode( node_name );
+	return node != NULL ? Attach( node ) : False;
+}
+
 } //namespace mdragon
 
 #endif // __MD_ACTOR3D_H__
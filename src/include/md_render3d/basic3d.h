@@ -146,6 +146,12 @@ public:
 	 */
 	inline const string & GetName() { return name; }
 
+	/// Returns interned name id, compare it instead of names.
+	/**
+	 * @return Returns name id, see NameTable.
+	 */
+	inline NameID GetNameID() { return NameTable::Instance().Intern( name.c_str() ); }
+
 	/// Returns pointer to parent object.
 	/**
 	 * @return Returns pointer to parent object.
@@ -0,0 +1,579 @@
+/** \file
+ *	Bounding volume hierarchy of static scene objects. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_BVH_H__
+#define __MD_BVH_H__
+
+namespace mdragon
+{
+
+/// Default maximal number of objects in SceneBVH leaf.
+#define SceneBVH_Leaf_Size 4
+
+/// Maximal depth of SceneBVH traversal stack.
+#define SceneBVH_Max_Depth 64
+
+
+/// Object stored in SceneBVH.
+class SceneBVHItem
+{
+public:
+
+	/// World bounding box of object.
+	AABB aabb;
+
+	/// Object.
+	ObjRef<Basic3D> object;
+};
+
+
+/// Node of SceneBVH.
+/**
+ *	Node covers items [first, first + count). Left child of inner node
+ *	follows it in array, right child is at index right. Leaf has right 0.
+ */
+class SceneBVHNode
+{
+public:
+
+	/// Bounding box of all node items.
+	AABB aabb;
+
+	/// First item.
+	Int first;
+
+	/// Number of items.
+	Int count;
+
+	/// Index of right child, 0 for leaf.
+	Int right;
+};
+
+
+/// Orders SceneBVH items by box center along axis.
+class SceneBVHCompare
+{
+public:
+
+	SceneBVHCompare( Int axis_ ) : axis( axis_ ) { ; }
+
+	inline Bool operator () ( const SceneBVHItem& a, const SceneBVHItem& b ) const
+	{
+		return Center( a.aabb ) < Center( b.aabb );
+	}
+
+	/// Returns doubled box center, raw fixed value.
+	inline Long Center( const AABB& aabb ) const
+	{
+		if( axis == 0 )
+			return (Long)aabb.min.x.value + aabb.max.x.value;
+		if( axis == 1 )
+			return (Long)aabb.min.y.value + aabb.max.y.value;
+		return (Long)aabb.min.z.value + aabb.max.z.value;
+	}
+
+	Int axis;
+};
+
+
+/// Bounding volume hierarchy of static objects.
+/**
+ *	Built once over objects having Basic3D_Flag_Static, for example list
+ *	returned by MDMLoad::Load(), and answers frustum, ray, sphere and box
+ *	queries in O(log n) instead of testing every object. Tree is binary,
+ *	split by median of box centers along the longest axis. Bounds are taken
+ *	at build time, so objects must not move; call Rebuild() if they do.
+ *	Queries append found objects to the list and do not clear it, so
+ *	dynamic objects are still tested by caller.
+ */
+class SceneBVH
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( SceneBVH, MemoryTag_Render3D )
+
+	/// Constructor.
+	SceneBVH()
+	{
+		leaf_size = SceneBVH_Leaf_Size;
+	}
+
+	/// Removes all objects.
+	void Clear()
+	{
+		items.clear();
+		nodes.clear();
+	}
+
+	/// Adds object with given bounds. Call Rebuild() after adding.
+	/**
+	 *	@param object - object.
+	 *	@param aabb - object world bounding box.
+	 */
+	void Add( ObjRef<Basic3D> object, const AABB& aabb )
+	{
+		items.push_back( SceneBVHItem() );
+		items[ items.size() - 1 ].aabb = aabb;
+		items[ items.size() - 1 ].object = object;
+	}
+
+	/// Adds object, bounds are computed by GetBounds(). Call Rebuild() after adding.
+	/**
+	 *	@param object - object.
+	 *	@return Returns False if object has no geometry and is not added.
+	 */
+	Bool Add( ObjRef<Basic3D> object )
+	{
+		AABB aabb;
+		if( !GetBounds( object, aabb ) )
+			return False;
+
+		Add( object, aabb );
+		return True;
+	}
+
+	/// Builds tree of static objects of list.
+	/**
+	 *	Objects without Basic3D_Flag_Static or without geometry are skipped
+	 *	and left to caller.
+	 *	@param list - scene objects.
+	 *	@return Returns number of objects in tree.
+	 */
+	Int Build( vector< ObjRef<Basic3D> >& list )
+	{
+		Clear();
+
+		for( Int i = 0; i < (Int)list.size(); i++ )
+			if( list[i] && list[i]->CheckFlag( Basic3D_Flag_Static ) )
+				Add( list[i] );
+
+		Rebuild();
+		return items.size();
+	}
+
+	/// Builds tree of added objects.
+	void Rebuild()
+	{
+		nodes.clear();
+		if( !items.size() )
+			return;
+
+		nodes.reserve( items.size() * 2 );
+		BuildNode( 0, items.size() );
+	}
+
+	/// Sets maximal number of objects in leaf, used by next Rebuild().
+	inline void SetLeafSize( Int leaf_size_ ) { leaf_size = leaf_size_ > 0 ? leaf_size_ : 1; }
+
+	/// Returns number of objects in tree.
+	inline Int GetCount() { return items.size(); }
+
+	/// Returns object by index.
+	inline ObjRef<Basic3D> GetObject( Int i ) { return items[i].object; }
+
+	/// Finds objects intersecting convex volume.
+	/**
+	 *	Subtrees fully inside the volume are added without testing.
+	 *	@param planes - planes of volume, inside is Plane::HalfSpaceContain().
+	 *	@param plane_count - number of planes, at most 32.
+	 *	@param list - list to append found objects to.
+	 *	@return Returns number of found objects.
+	 */
+	Int QueryVolume( const Plane* planes, Int plane_count, vector< ObjRef<Basic3D> >& list )
+	{
+		if( !nodes.size() )
+			return 0;
+
+		Int found = list.size();
+
+		Int stack[SceneBVH_Max_Depth];
+		DWord stack_mask[SceneBVH_Max_Depth];
+		Int depth = 1;
+
+		stack[0] = 0;
+		stack_mask[0] = plane_count < 32 ? ( 1UL << plane_count ) - 1 : 0xffffffffUL;
+
+		while( depth )
+		{
+			depth--;
+			Int index = stack[depth];
+			SceneBVHNode& node = nodes[index];
+			DWord mask = stack_mask[depth];
+
+			if( !ClipBox( node.aabb, planes, plane_count, mask ) )
+				continue;
+
+			if( !mask )
+			{
+				for( Int i = node.first; i < node.first + node.count; i++ )
+					list.push_back( items[i].object );
+				continue;
+			}
+
+			if( node.right )
+			{
+				stack[depth] = node.right;
+				stack_mask[depth++] = mask;
+				stack[depth] = index + 1;
+				stack_mask[depth++] = mask;
+				continue;
+			}
+
+			for( Int i = node.first; i < node.first + node.count; i++ )
+			{
+				DWord item_mask = mask;
+				if( ClipBox( items[i].aabb, planes, plane_count, item_mask ) )
+					list.push_back( items[i].object );
+			}
+		}
+
+		return list.size() - found;
+	}
+
+	/// Finds objects in current camera view frustum of render.
+	/**
+	 *	Replaces calling Render3D::IsVisible() for every static object.
+	 *	@param render - render, its frustum must be set up for frame.
+	 *	@param list - list to append found objects to.
+	 *	@return Returns number of found objects.
+	 */
+	inline Int QueryFrustum( Render3D& render, vector< ObjRef<Basic3D> >& list )
+	{
+		Plane planes[6];
+		render.GetWorldFrustum( planes );
+		return QueryVolume( planes, 6, list );
+	}
+
+	/// Finds objects whose bounds intersect ray.
+	/**
+	 *	@param p - ray start.
+	 *	@param d - ray direction.
+	 *	@param t_max - ray length in d units, segment is p + d * [0, t_max].
+	 *	@param list - list to append found objects to.
+	 *	@return Returns number of found objects.
+	 */
+	Int QueryRay( const Vector3fx& p, const Vector3fx& d, Fixed t_max, vector< ObjRef<Basic3D> >& list )
+	{
+		if( !nodes.size() )
+			return 0;
+
+		Int found = list.size();
+
+		Ray ray;
+		ray.p[0] = Float( p.x.value ) / 65536;
+		ray.p[1] = Float( p.y.value ) / 65536;
+		ray.p[2] = Float( p.z.value ) / 65536;
+		ray.d[0] = Float( d.x.value ) / 65536;
+		ray.d[1] = Float( d.y.value ) / 65536;
+		ray.d[2] = Float( d.z.value ) / 65536;
+		ray.t_max = Float( t_max.value ) / 65536;
+
+		Int stack[SceneBVH_Max_Depth];
+		Int depth = 1;
+		stack[0] = 0;
+
+		while( depth )
+		{
+			Int index = stack[--depth];
+			SceneBVHNode& node = nodes[index];
+
+			if( !ray.IsHit( node.aabb ) )
+				continue;
+
+			if( node.right )
+			{
+				stack[depth++] = node.right;
+				stack[depth++] = index + 1;
+				continue;
+			}
+
+			for( Int i = node.first; i < node.first + node.count; i++ )
+				if( ray.IsHit( items[i].aabb ) )
+					list.push_back( items[i].object );
+		}
+
+		return list.size() - found;
+	}
+
+	/// Checks ray against objects hit by QueryRay().
+	/**
+	 *	Same as Render3D::CheckRay(p,d,o3d_list) with list of all static
+	 *	objects, but only objects whose bounds are hit are checked.
+	 *	@param render - render.
+	 *	@param p - ray start.
+	 *	@param d - ray direction.
+	 *	@param t_max - ray length in d units.
+	 *	@return Returns result of Render3D::CheckRay().
+	 */
+	Fixed CheckRay( Render3D& render, Vector3fx& p, Vector3fx& d, Fixed t_max )
+	{
+		candidates.clear();
+		QueryRay( p, d, t_max, candidates );
+		return render.CheckRay( p, d, candidates );
+	}
+
+	/// Finds objects whose bounds intersect sphere.
+	/**
+	 *	Use it to select objects for CollisionManager::Collide().
+	 *	@param sphere - sphere.
+	 *	@param list - list to append found objects to.
+	 *	@return Returns number of found objects.
+	 */
+	Int QuerySphere( const Sphere& sphere, vector< ObjRef<Basic3D> >& list )
+	{
+		return Query( sphere.aabb, &sphere, list );
+	}
+
+	/// Finds objects whose bounds intersect box.
+	/**
+	 *	@param aabb - box.
+	 *	@param list - list to append found objects to.
+	 *	@return Returns number of found objects.
+	 */
+	Int QueryAABB( const AABB& aabb, vector< ObjRef<Basic3D> >& list )
+	{
+		return Query( aabb, NULL, list );
+	}
+
+	/// Computes world bounding box of object and its children.
+	/**
+	 *	Uses VertexBuffer bounds of Object3D and its children transformed
+	 *	by result transform matrices.
+	 *	@param object - object.
+	 *	@param aabb - receives bounding box.
+	 *	@return Returns False if object has no geometry.
+	 */
+	static Bool GetBounds( ObjRef<Basic3D> object, AABB& aabb )
+	{
+		if( !object || object->GetClassID() != ClassID_Object3D )
+			return False;
+
+		ObjRef<Object3D> o3d = object.cast( (Object3D*)NULL );
+		Bool found = False;
+
+		if( o3d->vb )
+		{
+			Matrix4fx m = o3d->GetResultTransform();
+			Vector3fx lo = o3d->vb->GetMin();
+			Vector3fx hi = o3d->vb->GetMax();
+
+			for( Int i = 0; i < 8; i++ )
+			{
+				Vector3fx v( ( i & 1 ) ? hi.x : lo.x, ( i & 2 ) ? hi.y : lo.y, ( i & 4 ) ? hi.z : lo.z );
+				v = TransformVector3( v, m );
+
+				if( found )
+					aabb.Add( v );
+				else
+					aabb.min = aabb.max = v;
+				found = True;
+			}
+		}
+
+		for( Int i = 0; i < (Int)o3d->children.size(); i++ )
+		{
+			AABB child;
+			if( !GetBounds( o3d->children[i], child ) )
+				continue;
+
+			if( found )
+				aabb.Add( child );
+			else
+				aabb = child;
+			found = True;
+		}
+
+		return found;
+	}
+
+private:
+
+	/// Ray in floating point, avoids fixed overflow of long rays.
+	struct Ray
+	{
+		Float p[3];
+		Float d[3];
+		Float t_max;
+
+		/// Slab test of segment against box.
+		Bool IsHit( const AABB& aabb ) const
+		{
+			Float lo[3] = { Float( aabb.min.x.value ) / 65536, Float( aabb.min.y.value ) / 65536, Float( aabb.min.z.value ) / 65536 };
+			Float hi[3] = { Float( aabb.max.x.value ) / 65536, Float( aabb.max.y.value ) / 65536, Float( aabb.max.z.value ) / 65536 };
+
+			Float t0 = 0;
+			Float t1 = t_max;
+
+			for( Int i = 0; i < 3; i++ )
+			{
+				if( d[i] == 0 )
+				{
+					if( p[i] < lo[i] || p[i] > hi[i] )
+						return False;
+					continue;
+				}
+
+				Float ta = ( lo[i] - p[i] ) / d[i];
+				Float tb = ( hi[i] - p[i] ) / d[i];
+				if( ta > tb )
+				{
+					Float t = ta;
+					ta = tb;
+					tb = t;
+				}
+
+				if( ta > t0 )
+					t0 = ta;
+				if( tb < t1 )
+					t1 = tb;
+				if( t0 > t1 )
+					return False;
+			}
+
+			return True;
+		}
+	};
+
+	/// Builds node of items [first, first + count), returns its index.
+	Int BuildNode( Int first, Int count )
+	{
+		Int index = nodes.size();
+		nodes.push_back( SceneBVHNode() );
+
+		AABB aabb = items[first].aabb;
+		for( Int i = first + 1; i < first + count; i++ )
+			aabb.Add( items[i].aabb );
+
+		nodes[index].aabb = aabb;
+		nodes[index].first = first;
+		nodes[index].count = count;
+		nodes[index].right = 0;
+
+		if( count <= leaf_size )
+			return index;
+
+		// Split by median along the longest axis of node box.
+		Long sx = (Long)aabb.max.x.value - aabb.min.x.value;
+		Long sy = (Long)aabb.max.y.value - aabb.min.y.value;
+		Long sz = (Long)aabb.max.z.value - aabb.min.z.value;
+		Int axis = ( sx >= sy && sx >= sz ) ? 0 : ( sy >= sz ? 1 : 2 );
+
+		sort( items.begin() + first, items.begin() + first + count, SceneBVHCompare( axis ) );
+
+		Int half = count / 2;
+		BuildNode( first, half );
+		Int right = BuildNode( first + half, count - half );
+
+		nodes[index].right = right;
+		return index;
+	}
+
+	/// Tests box against planes of mask.
+	/**
+	 *	Clears from mask planes the box is fully inside.
+	 *	@return Returns False if box is outside of some plane.
+	 */
+	static Bool ClipBox( const AABB& aabb, const Plane* planes, Int plane_count, DWord& mask )
+	{
+		for( Int i = 0; i < plane_count; i++ )
+		{
+			if( !( mask & ( 1UL << i ) ) )
+				continue;
+
+			const Plane& pl = planes[i];
+
+			// Corner farthest along normal.
+			Vector3fx v( pl.N.x >= F_ZERO ? aabb.max.x : aabb.min.x,
+						 pl.N.y >= F_ZERO ? aabb.max.y : aabb.min.y,
+						 pl.N.z >= F_ZERO ? aabb.max.z : aabb.min.z );
+
+			if( !pl.HalfSpaceContain( v ) )
+				return False;
+
+			// Opposite corner inside means whole box is inside.
+			v = Vector3fx( pl.N.x >= F_ZERO ? aabb.min.x : aabb.max.x,
+						   pl.N.y >= F_ZERO ? aabb.min.y : aabb.max.y,
+						   pl.N.z >= F_ZERO ? aabb.min.z : aabb.max.z );
+
+			if( pl.HalfSpaceContain( v ) )
+				mask &= ~( 1UL << i );
+		}
+
+		return True;
+	}
+
+	/// Tests box against sphere, in floating point.
+	static Bool IsSphereHit( const AABB& aabb, const Sphere& sphere )
+	{
+		Float c[3] = { Float( sphere.center.x.value ) / 65536, Float( sphere.center.y.value ) / 65536, Float( sphere.center.z.value ) / 65536 };
+		Float lo[3] = { Float( aabb.min.x.value ) / 65536, Float( aabb.min.y.value ) / 65536, Float( aabb.min.z.value ) / 65536 };
+		Float hi[3] = { Float( aabb.max.x.value ) / 65536, Float( aabb.max.y.value ) / 65536, Float( aabb.max.z.value ) / 65536 };
+
+		Float dist = 0;
+		for( Int i = 0; i < 3; i++ )
+		{
+			Float e = c[i] < lo[i] ? lo[i] - c[i] : ( c[i] > hi[i] ? c[i] - hi[i] : 0 );
+			dist += e * e;
+		}
+
+		Float r = Float( sphere.radius.value ) / 65536;
+		return dist <= r * r;
+	}
+
+	/// Finds objects intersecting box and optional sphere.
+	Int Query( const AABB& aabb, const Sphere* sphere, vector< ObjRef<Basic3D> >& list )
+	{
+		if( !nodes.size() )
+			return 0;
+
+		Int found = list.size();
+
+		Int stack[SceneBVH_Max_Depth];
+		Int depth = 1;
+		stack[0] = 0;
+
+		while( depth )
+		{
+			Int index = stack[--depth];
+			SceneBVHNode& node = nodes[index];
+
+			if( !node.aabb.IsCollide( aabb ) || ( sphere && !IsSphereHit( node.aabb, *sphere ) ) )
+				continue;
+
+			if( node.right )
+			{
+				stack[depth++] = node.right;
+				stack[depth++] = index + 1;
+				continue;
+			}
+
+			for( Int i = node.first; i < node.first + node.count; i++ )
+				if( items[i].aabb.IsCollide( aabb ) && ( !sphere || IsSphereHit( items[i].aabb, *sphere ) ) )
+					list.push_back( items[i].object );
+		}
+
+		return list.size() - found;
+	}
+
+	SceneBVH( const SceneBVH& );
+	SceneBVH& operator = ( const SceneBVH& );
+
+	/// Objects, every node covers continuous range.
+	vector<SceneBVHItem> items;
+
+	/// Nodes, root is first.
+	vector<SceneBVHNode> nodes;
+
+	/// Scratch list of CheckRay().
+	vector< ObjRef<Basic3D> > candidates;
+
+	Int leaf_size;
+};
+
+} //namespace mdragon
+
+#endif // __MD_BVH_H__
@@ -0,0 +1,172 @@
+/** \file
+ *	Depth sorting of triangle heap. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_DEPTHSORT_H__
+#define __MD_DEPTHSORT_H__
+
+namespace mdragon
+{
+
+/// Sort key of TriangleS for nearest first order.
+struct TriangleNearKey
+{
+	inline DWord operator () ( const TriangleS* t ) const { return (DWord)t->z ^ 0x80000000U; }
+};
+
+/// Sort key of TriangleS for farthest first order.
+struct TriangleFarKey
+{
+	inline DWord operator () ( const TriangleS* t ) const { return ~( (DWord)t->z ^ 0x80000000U ); }
+};
+
+
+/// Sorts triangle heap by TriangleS::z.
+/**
+ *	First frame and frames with changed triangle count are sorted by
+ *	radix_sort(). Otherwise previous frame order is applied to the heap and
+ *	fixed by insertion sort; if camera moved enough to need more than
+ *	max_moves moves, radix_sort() is used instead. Static scenes submit
+ *	triangles in the same order every frame, so their order is kept
+ *	between frames in linear time.
+ */
+class DepthSorter
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( DepthSorter, MemoryTag_Render3D )
+
+	/// Constructor.
+	DepthSorter()
+	{
+		last_count = -1;
+		last_far_first = False;
+		max_moves = -1;
+		incremental_count = 0;
+		full_count = 0;
+	}
+
+	/// Allocates scratch buffers.
+	/**
+	 *	@param size - maximal number of triangles to sort.
+	 */
+	void Init( Int size )
+	{
+		buffer.resize( size );
+		order.resize( size );
+		last_count = -1;
+	}
+
+	/// Sets maximal number of insertion sort moves per frame.
+	/**
+	 *	@param max_moves_ - maximal number of moves, negative for triangle count.
+	 *	0 disables incremental sorting.
+	 */
+	inline void SetMaxMoves( Int max_moves_ ) { max_moves = max_moves_; }
+
+	/// Forgets previous frame order, next Sort() will do full sort.
+	inline void Reset() { last_count = -1; }
+
+	/// Sorts triangles.
+	/**
+	 *	@param heap - triangle heap.
+	 *	@param sorted - receives pointers to heap triangles in sorted order.
+	 *	@param count - number of triangles in heap.
+	 *	@param far_first - True for back to front order, False for front to back.
+	 */
+	void Sort( TriangleS* heap, TriangleS** sorted, Int count, Bool far_first )
+	{
+		RENDER3D_PROFILE_SCOPE( Render3D_Stage_Sort )
+		RENDER3D_PROFILE_COUNT( triangles_sorted, count )
+
+		if( count > (Int)buffer.size() )
+			Init( count );
+
+		if( count == last_count && far_first == last_far_first && max_moves != 0 )
+		{
+			Bool done = far_first ? Incremental( heap, sorted, count, TriangleFarKey() ) :
+					Incremental( heap, sorted, count, TriangleNearKey() );
+
+			if( done )
+			{
+				incremental_count++;
+				StoreOrder( heap, sorted, count );
+				return;
+			}
+		}
+
+		for( Int i = 0; i < count; i++ )
+			sorted[i] = heap + i;
+
+		if( far_first )
+			radix_sort( sorted, sorted + count, buffer.begin(), TriangleFarKey() );
+		else
+			radix_sort( sorted, sorted + count, buffer.begin(), TriangleNearKey() );
+
+		full_count++;
+		last_count = count;
+		last_far_first = far_first;
+		StoreOrder( heap, sorted, count );
+	}
+
+	/// Returns number of frames sorted incrementally.
+	inline Int GetIncrementalCount() { return incremental_count; }
+
+	/// Returns number of frames sorted by radix_sort().
+	inline Int GetFullCount() { return full_count; }
+
+private:
+
+	template <class KeyFunction>
+	Bool Incremental( TriangleS* heap, TriangleS** sorted, Int count, KeyFunction key )
+	{
+		Int moves = 0;
+		Int limit = max_moves < 0 ? count : max_moves;
+
+		for( Int i = 0; i < count; i++ )
+			sorted[i] = heap + order[i];
+
+		for( Int i = 1; i < count; i++ )
+		{
+			TriangleS* t = sorted[i];
+			DWord k = key( t );
+			Int j = i;
+
+			while( j > 0 && k < key( sorted[j-1] ) )
+			{
+				sorted[j] = sorted[j-1];
+				j--;
+
+				if( ++moves > limit )
+					return False;
+			}
+
+			sorted[j] = t;
+		}
+
+		return True;
+	}
+
+	void StoreOrder( TriangleS* heap, TriangleS** sorted, Int count )
+	{
+		for( Int i = 0; i < count; i++ )
+			order[i] = (Int)( sorted[i] - heap );
+	}
+
+	vector<TriangleS*> buffer;
+	vector<Int> order;
+
+	Int last_count;
+	Bool last_far_first;
+	Int max_moves;
+
+	Int incremental_count;
+	Int full_count;
+};
+
+} //namespace mdragon
+
+#endif // __MD_DEPTHSORT_H__
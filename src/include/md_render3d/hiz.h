@@ -0,0 +1,258 @@
+/** \file
+ *	Hierarchical depth buffer for occlusion tests. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_HIZ_H__
+#define __MD_HIZ_H__
+
+namespace mdragon
+{
+
+/// Default size of the finest HiZBuffer cell in pixels.
+#define HiZBuffer_Block_Size 8
+
+/// Maximal number of HiZBuffer levels.
+#define HiZBuffer_Max_Levels 12
+
+
+
+/// Converts view distance to Z-buffer depth.
+/**
+ *	Render3D keeps 16 bit 1/z in 16.16 fixed point in high half of every
+ *	backbuffer pixel, the same value it writes to VertexS::z, so nearer
+ *	depth is greater. Distances up to 1 give the nearest depth.
+ *	@param z - distance from camera along view direction.
+ *	@return Returns depth in Z-buffer units.
+ */
+inline Word DepthToZBuffer( Fixed z )
+{
+	return z.value > ( 1 << 16 ) ? (Word)( 0x40000000U / (DWord)( z.value >> 2 ) ) : (Word)0xFFFF;
+}
+
+/// Returns Z-buffer depth of backbuffer pixel.
+inline Word PixelToZBuffer( DWord pixel ) { return (Word)( pixel >> 16 ); }
+
+
+/// Low resolution pyramid of farthest depth values.
+/**
+ *	Every cell of level 0 holds farthest depth of Block x Block pixels of
+ *	Z-buffer, every cell of next level holds farthest depth of 2 x 2 cells
+ *	of previous one. Screen rectangle whose nearest depth is farther than
+ *	all cells covering it is hidden by drawn geometry.
+ *	Depth values are in Z-buffer units, see DepthToZBuffer(). Built by
+ *	caller after Render3D::Flush(), see Render3D::UpdateHiZ().
+ */
+class HiZBuffer
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( HiZBuffer, MemoryTag_Render3D )
+
+	/// Constructor.
+	HiZBuffer()
+	{
+		width = height = 0;
+		block = HiZBuffer_Block_Size;
+		level_count = 0;
+		tested = rejected = 0;
+	}
+
+	/// Allocates pyramid for Z-buffer of given size.
+	/**
+	 *	@param width_ - Z-buffer width in pixels.
+	 *	@param height_ - Z-buffer height in pixels.
+	 *	@param block_ - level 0 cell size in pixels.
+	 */
+	void Init( Int width_, Int height_, Int block_ = HiZBuffer_Block_Size )
+	{
+		width = width_;
+		height = height_;
+		block = block_ > 0 ? block_ : HiZBuffer_Block_Size;
+
+		Int w = ( width + block - 1 ) / block;
+		Int h = ( height + block - 1 ) / block;
+
+		for( level_count = 0; level_count < HiZBuffer_Max_Levels; level_count++ )
+		{
+			level_width[level_count] = w;
+			level_height[level_count] = h;
+			levels[level_count].resize( w * h );
+
+			if( w == 1 && h == 1 )
+			{
+				level_count++;
+				break;
+			}
+
+			w = ( w + 1 ) / 2;
+			h = ( h + 1 ) / 2;
+		}
+	}
+
+	/// Sets all cells to given depth, usually clear depth of Z-buffer.
+	void Clear( Word depth )
+	{
+		for( Int l = 0; l < level_count; l++ )
+			for( Int i = 0; i < (Int)levels[l].size(); i++ )
+				levels[l][i] = depth;
+	}
+
+	/// Rebuilds cells covering Z-buffer rectangle.
+	/**
+	 *	Called after rectangle of backbuffer was drawn.
+	 *	@param z - pointer to the first backbuffer pixel, depth is in high half.
+	 *	@param pitch - backbuffer line length in pixels.
+	 *	@param x1, y1, x2, y2 - drawn rectangle in pixels (inclusive).
+	 */
+	void Update( const DWord* z, Int pitch, Int x1, Int y1, Int x2, Int y2 )
+	{
+		RENDER3D_PROFILE_SCOPE( Render3D_Stage_Occlusion )
+
+		if( !level_count || !Clip( x1, y1, x2, y2 ) )
+			return;
+
+		Int bx1 = x1 / block, by1 = y1 / block;
+		Int bx2 = x2 / block, by2 = y2 / block;
+
+		for( Int by = by1; by <= by2; by++ )
+		{
+			for( Int bx = bx1; bx <= bx2; bx++ )
+			{
+				Int px2 = min( ( bx + 1 ) * block, width );
+				Int py2 = min( ( by + 1 ) * block, height );
+				const DWord* line = z + by * block * pitch;
+				Word m = PixelToZBuffer( line[ bx * block ] );
+
+				for( Int y = by * block; y < py2; y++, line += pitch )
+					for( Int x = bx * block; x < px2; x++ )
+						if( Farther( PixelToZBuffer( line[x] ), m ) )
+							m = PixelToZBuffer( line[x] );
+
+				levels[0][ by * level_width[0] + bx ] = m;
+			}
+		}
+
+		for( Int l = 1; l < level_count; l++ )
+		{
+			bx1 >>= 1; by1 >>= 1; bx2 >>= 1; by2 >>= 1;
+
+			const Word* src = levels[l-1].begin();
+			Int sw = level_width[l-1], sh = level_height[l-1];
+
+			for( Int by = by1; by <= by2; by++ )
+			{
+				for( Int bx = bx1; bx <= bx2; bx++ )
+				{
+					Int sx = bx * 2, sy = by * 2;
+					const Word* s = src + sy * sw + sx;
+					Word m = s[0];
+
+					if( sx + 1 < sw && Farther( s[1], m ) ) m = s[1];
+					if( sy + 1 < sh && Farther( s[sw], m ) ) m = s[sw];
+					if( sx + 1 < sw && sy + 1 < sh && Farther( s[sw+1], m ) ) m = s[sw+1];
+
+					levels[l][ by * level_width[l] + bx ] = m;
+				}
+			}
+		}
+	}
+
+	/// Checks if screen rectangle may be visible.
+	/**
+	 *	Uses the finest level where rectangle covers at most 4 x 4 cells.
+	 *	@param x1, y1, x2, y2 - screen rectangle in pixels (inclusive).
+	 *	@param near_z - nearest depth of tested geometry, see DepthToZBuffer().
+	 *	@return False if rectangle is hidden by drawn geometry, else True.
+	 */
+	Bool TestRect( Int x1, Int y1, Int x2, Int y2, Word near_z )
+	{
+		if( !level_count || !Clip( x1, y1, x2, y2 ) )
+			return level_count == 0;
+
+		tested++;
+
+		Int bx1 = x1 / block, by1 = y1 / block;
+		Int bx2 = x2 / block, by2 = y2 / block;
+		Int l = 0;
+
+		while( l + 1 < level_count && ( bx2 - bx1 > 3 || by2 - by1 > 3 ) )
+		{
+			bx1 >>= 1; by1 >>= 1; bx2 >>= 1; by2 >>= 1;
+			l++;
+		}
+
+		for( Int by = by1; by <= by2; by++ )
+			for( Int bx = bx1; bx <= bx2; bx++ )
+				if( !Farther( near_z, levels[l][ by * level_width[l] + bx ] ) )
+					return True;
+
+		rejected++;
+		return False;
+	}
+
+	/// Checks if projected triangle may be visible.
+	/**
+	 *	Tests screen bounding box and nearest vertex depth. VertexS::z is
+	 *	1/z written by Render3D, the same units as Z-buffer. Used by
+	 *	Render3D::CullQueue() on triangles queued for Flush().
+	 *	@return False if triangle is hidden by drawn geometry, else True.
+	 */
+	Bool TestTriangle( const TriangleS* t )
+	{
+		Word z = t->a.z;
+		if( Farther( z, t->b.z ) ) z = t->b.z;
+		if( Farther( z, t->c.z ) ) z = t->c.z;
+
+		return TestRect( min( t->a.sx, min( t->b.sx, t->c.sx ) ), min( t->a.sy, min( t->b.sy, t->c.sy ) ),
+				max( t->a.sx, max( t->b.sx, t->c.sx ) ), max( t->a.sy, max( t->b.sy, t->c.sy ) ), z );
+	}
+
+	/// Returns Z-buffer width the pyramid was made for.
+	inline Int GetWidth() { return width; }
+
+	/// Returns Z-buffer height the pyramid was made for.
+	inline Int GetHeight() { return height; }
+
+	/// Returns number of TestRect() calls on screen since ResetCounters().
+	inline Int GetTestedCount() { return tested; }
+
+	/// Returns number of rejected rectangles since ResetCounters().
+	inline Int GetRejectedCount() { return rejected; }
+
+	/// Zeroes test counters.
+	inline void ResetCounters() { tested = rejected = 0; }
+
+private:
+
+	/// Returns True if depth a is farther than depth b, nearer depth is greater.
+	inline Bool Farther( Word a, Word b ) { return a < b; }
+
+	/// Clips rectangle to buffer, returns False if nothing left.
+	inline Bool Clip( Int& x1, Int& y1, Int& x2, Int& y2 )
+	{
+		if( x1 < 0 ) x1 = 0;
+		if( y1 < 0 ) y1 = 0;
+		if( x2 >= width ) x2 = width - 1;
+		if( y2 >= height ) y2 = height - 1;
+
+		return x1 <= x2 && y1 <= y2;
+	}
+
+	Int width, height;
+	Int block;
+
+	Int level_count;
+	Int level_width[HiZBuffer_Max_Levels];
+	Int level_height[HiZBuffer_Max_Levels];
+	vector<Word> levels[HiZBuffer_Max_Levels];
+
+	Int tested;
+	Int rejected;
+};
+
+} //namespace mdragon
+
+#endif // __MD_HIZ_H__
@@ -0,0 +1,347 @@
+/** \file
+ *	Level of detail manager. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_LODMANAGER_H__
+#define __MD_LODMANAGER_H__
+
+namespace mdragon
+{
+
+/// Maximal number of VBs in LOD chain used by LODManager.
+#define LODManager_Max_Levels		8
+
+/// Default relative distance margin before LOD level changes.
+#define LODManager_Hysteresis		0.1f
+
+/// Triangle budget meaning no limit.
+#define LODManager_No_Budget		0
+
+
+/// Object handled by LODManager.
+class LODManagerEntry
+{
+public:
+
+	/// Object, its vb is base of LOD chain.
+	ObjRef<Object3D> object;
+
+	/// First level in LODManager VB list.
+	Int first;
+
+	/// Number of levels.
+	Int count;
+
+	/// Level chosen by distance with hysteresis, -1 before first LODManager::Update().
+	Int level;
+
+	/// Level drawn, may be coarser because of triangle budget.
+	Int draw_level;
+
+	/// Distance from camera scaled by projection, updated by LODManager::Update().
+	Float distance;
+
+	/// Is object in view frustum.
+	Bool visible;
+};
+
+
+/// Orders LODManager entries from far to near.
+class LODManagerFarFirst
+{
+public:
+
+	LODManagerFarFirst( const vector<LODManagerEntry>& entries_ ) : entries( entries_ ) { ; }
+
+	inline Bool operator () ( Int a, Int b ) const { return entries[a].distance > entries[b].distance; }
+
+	const vector<LODManagerEntry>& entries;
+};
+
+
+/// Selects LOD levels of Object3D VBs for whole scene.
+/**
+ *	Works on VB chains linked by VertexBuffer::AddLODVB(), of any length,
+ *	with switch radii set by Render3D::LoadLODSettings(). Radii are taken
+ *	as distances where geometric error of level projects to tolerated
+ *	screen error at reference projection, so with other field of view or
+ *	screen height level is chosen by the same screen space error. Level
+ *	changes only when distance passes switch radius by hysteresis margin,
+ *	so objects near switch radius do not pop. If triangles of visible
+ *	objects exceed budget, the farthest objects are drawn with coarser
+ *	levels first. Object3D::Draw() selects levels by itself, so for
+ *	managed objects take chosen VB by GetVB() and send it to
+ *	Render3D::Draw() with object world transform and material.
+ */
+class LODManager
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( LODManager, MemoryTag_Render3D )
+
+	/// Constructor.
+	LODManager()
+	{
+		hysteresis = LODManager_Hysteresis;
+		budget = LODManager_No_Budget;
+		projection = reference_projection = 0;
+		bias = 1;
+		triangles = 0;
+	}
+
+	/// Removes all objects.
+	void Clear()
+	{
+		entries.clear();
+		vbs.clear();
+		index.clear();
+	}
+
+	/// Adds object and its children having LOD chains.
+	/**
+	 *	@param object - object, usually one of lists given to Render3D::LoadLODSettings().
+	 *	@return Returns number of objects added.
+	 */
+	Int Add( ObjRef<Basic3D> object )
+	{
+		if( !object || object->GetClassID() != ClassID_Object3D )
+			return 0;
+
+		ObjRef<Object3D> o3d = object.cast( (Object3D*)NULL );
+		Int added = 0;
+
+		if( o3d->vb && o3d->vb->GetLODVB() && !index.count( (const Object3D*)o3d ) )
+		{
+			LODManagerEntry e;
+			e.object = o3d;
+			e.first = vbs.size();
+			e.count = 0;
+			e.level = -1;
+			e.draw_level = 0;
+			e.distance = 0;
+			e.visible = True;
+
+			for( ObjRef<VertexBuffer> vb = o3d->vb; vb && e.count < LODManager_Max_Levels; vb = vb->GetLODVB() )
+			{
+				vbs.push_back( vb );
+				e.count++;
+			}
+
+			index.insert( (const Object3D*)o3d, entries.size() );
+			entries.push_back( e );
+			added++;
+		}
+
+		for( Int i = 0; i < (Int)o3d->children.size(); i++ )
+			added += Add( o3d->children[i] );
+
+		return added;
+	}
+
+	/// Adds objects of list and their children having LOD chains.
+	/**
+	 *	@param list - objects.
+	 *	@return Returns number of objects added.
+	 */
+	Int Add( vector< ObjRef<Basic3D> >& list )
+	{
+		Int added = 0;
+		for( Int i = 0; i < (Int)list.size(); i++ )
+			added += Add( list[i] );
+		return added;
+	}
+
+	/// Sets current projection.
+	/**
+	 *	First call sets reference projection too.
+	 *	@param fovy - vertical field of view in radians, as given to Render3D::SetPerspective().
+	 *	@param screen_height - viewport height in pixels.
+	 */
+	void SetProjection( Fixed fovy, Int screen_height )
+	{
+		projection = GetProjection( fovy, screen_height );
+
+		if( !reference_projection )
+			reference_projection = projection;
+	}
+
+	/// Sets projection LOD switch radii were tuned for.
+	/**
+	 *	@param fovy - vertical field of view in radians.
+	 *	@param screen_height - viewport height in pixels.
+	 */
+	inline void SetReferenceProjection( Fixed fovy, Int screen_height )
+	{
+		reference_projection = GetProjection( fovy, screen_height );
+	}
+
+	/// Sets tolerated screen error relative to tuned one.
+	/**
+	 *	@param bias_ - 2 allows twice larger error, so coarser levels are used twice nearer.
+	 */
+	inline void SetErrorBias( Float bias_ ) { bias = bias_ > 0 ? bias_ : 1; }
+
+	/// Sets relative distance margin before level changes, 0.1 is 10 percents.
+	inline void SetHysteresis( Float hysteresis_ ) { hysteresis = hysteresis_ >= 0 ? hysteresis_ : 0; }
+
+	/// Sets maximal number of triangles of visible managed objects per frame.
+	/**
+	 *	@param budget_ - triangle count, LODManager_No_Budget for no limit.
+	 */
+	inline void SetTriangleBudget( Int budget_ ) { budget = budget_; }
+
+	/// Chooses levels for frame.
+	/**
+	 *	Call after camera and object transforms are updated, before drawing.
+	 *	@param render - render, its frustum is used to skip hidden objects in budget.
+	 *	@param camera_pos - camera position.
+	 *	@return Returns number of triangles of visible objects at chosen levels.
+	 */
+	Int Update( Render3D& render, const Vector3fx& camera_pos )
+	{
+		Plane frustum[6];
+		render.GetWorldFrustum( frustum );
+
+		// Distance is scaled, so radii tuned at reference projection give the same screen error.
+		Float scale = projection > 0 && reference_projection > 0 ? reference_projection / ( projection * bias ) : 1 / bias;
+
+		triangles = 0;
+		order.clear();
+
+		for( Int i = 0; i < (Int)entries.size(); i++ )
+		{
+			LODManagerEntry& e = entries[i];
+			ObjRef<VertexBuffer>& base = vbs[e.first];
+
+			Vector3fx center = TransformVector3( base->GetCenter(), e.object->GetResultTransform() );
+			Fixed radius = base->GetRadius();
+
+			Float dx = ToFloat( center.x - camera_pos.x );
+			Float dy = ToFloat( center.y - camera_pos.y );
+			Float dz = ToFloat( center.z - camera_pos.z );
+			e.distance = (Float)MDSqrt( dx * dx + dy * dy + dz * dz ) * scale;
+
+			e.visible = True;
+			for( Int k = 0; k < 6 && e.visible; k++ )
+				if( DotProduct( frustum[k].N, center ) < frustum[k].D - radius )
+					e.visible = False;
+
+			// Coarser only beyond radius plus margin, finer only within radius minus margin.
+			Int coarse = GetLevel( e, e.distance / ( 1 + hysteresis ) );
+			Int fine = GetLevel( e, e.distance * ( 1 + hysteresis ) );
+
+			if( e.level < 0 )
+				e.level = GetLevel( e, e.distance );
+			else
+			if( coarse > e.level )
+				e.level = coarse;
+			else
+			if( fine < e.level )
+				e.level = fine;
+
+			e.draw_level = e.level;
+
+			if( e.visible )
+			{
+				triangles += GetTriangles( e, e.draw_level );
+				order.push_back( i );
+			}
+		}
+
+		if( budget != LODManager_No_Budget && triangles > budget )
+		{
+			sort( order.begin(), order.end(), LODManagerFarFirst( entries ) );
+
+			for( Int i = 0; i < (Int)order.size() && triangles > budget; i++ )
+			{
+				LODManagerEntry& e = entries[ order[i] ];
+
+				while( e.draw_level < e.count - 1 && triangles > budget )
+				{
+					triangles -= GetTriangles( e, e.draw_level );
+					e.draw_level++;
+					triangles += GetTriangles( e, e.draw_level );
+				}
+			}
+		}
+
+		return triangles;
+	}
+
+	/// Returns VB chosen for object by last Update().
+	/**
+	 *	@param object - object.
+	 *	@return Returns chosen VB, or NULL reference if object is not managed.
+	 */
+	ObjRef<VertexBuffer> GetVB( const Object3D* object )
+	{
+		Int* i = index.get( object );
+		if( !i )
+			return ObjRef<VertexBuffer>();
+
+		return vbs[ entries[*i].first + entries[*i].draw_level ];
+	}
+
+	/// Returns number of managed objects.
+	inline Int GetCount() { return entries.size(); }
+
+	/// Returns managed object state.
+	inline const LODManagerEntry& GetEntry( Int i ) { return entries[i]; }
+
+	/// Returns triangles of visible objects counted by last Update().
+	inline Int GetTriangleCount() { return triangles; }
+
+private:
+
+	static inline Float ToFloat( const Fixed& f ) { return Float( f.value ) / 65536; }
+
+	/// Returns pixels per world unit at distance 1.
+	static Float GetProjection( Fixed fovy, Int screen_height )
+	{
+		Float t = ToFloat( Tan( fovy / 2 ) );
+		return t > 0 ? screen_height / ( 2 * t ) : 0;
+	}
+
+	/// Returns level for distance, level i is used while distance is less than its switch radius.
+	inline Int GetLevel( const LODManagerEntry& e, Float distance )
+	{
+		Int level = 0;
+		while( level < e.count - 1 && distance >= ToFloat( vbs[ e.first + level ]->GetLODSwitchRadius() ) )
+			level++;
+		return level;
+	}
+
+	inline Int GetTriangles( const LODManagerEntry& e, Int level )
+	{
+		return vbs[ e.first + level ]->GetIndexCount() / 3;
+	}
+
+	LODManager( const LODManager& );
+	LODManager& operator = ( const LODManager& );
+
+	vector<LODManagerEntry> entries;
+
+	/// LOD chains of entries.
+	vector< ObjRef<VertexBuffer> > vbs;
+
+	/// Entry index of each managed object.
+	hash_map<const Object3D*, Int> index;
+
+	/// Visible entries, sorted far first when budget is exceeded.
+	vector<Int> order;
+
+	Float hysteresis;
+	Float projection;
+	Float reference_projection;
+	Float bias;
+
+	Int budget;
+	Int triangles;
+};
+
+} //namespace mdragon
+
+#endif // __MD_LODMANAGER_H__
@@ -238,7 +238,7 @@ void ParticleManager<InitPolicy, UpdatePolicy>::Update(Fixed &frame_time)
 				is_alive = False;
 		}
 
-		for (i = 0; i < curr_count; i++)
+		for (Int i = 0; i < curr_count; i++)
 			pUpdate(&pArr[i], frame_time);
 		
 		
@@ -114,6 +114,395 @@ inline void FindPlane(Vector3fx& n,Int& x,Int& y,Int& z)
 	}
 }
 
+/// Maximal number of points in ScreenPolygon.
+#define POLYCLIP_MAX_POINTS 16
+
+/// Integer screen rectangle, bounds are inclusive.
+/**
+ * Pixel x covers [x,x+1), so rectangle covers [x1,x2+1) by [y1,y2+1).
+ */
+class ClipRect
+{
+public:
+
+	/// Default constructor.
+	ClipRect() {}
+
+	/// Constructor with given bounds.
+	ClipRect(Int x1_,Int y1_,Int x2_,Int y2_) { x1=x1_; y1=y1_; x2=x2_; y2=y2_; }
+
+	/// Checks if rectangle has no pixels.
+	inline Bool IsEmpty() const { return x1>x2 || y1>y2; }
+
+	/// Leaves part of rectangle inside another one.
+	/**
+	 * @param r - another rectangle.
+	 * @return Returns False if nothing is left.
+	 */
+	inline Bool Intersect(const ClipRect& r)
+	{
+		x1=max(x1,r.x1);
+		y1=max(y1,r.y1);
+		x2=min(x2,r.x2);
+		y2=min(y2,r.y2);
+		return !IsEmpty();
+	}
+
+	Int x1;
+	Int y1;
+	Int x2;
+	Int y2;
+};
+
+
+/// Convex polygon in screen coordinates stored without heap allocation.
+/**
+ * Header replacement for vector<Point> Clipping() in user code. Portal
+ * traversal of the engine library does not use either of them:
+ * Portal::Project() clips by Render3D::ClipPolygon() in fixed arrays and
+ * Portal::Clip() intersects per scanline spans, neither allocates.
+ * Rectangles, most projected portals, are clipped by ClipByRect() with
+ * four axis tests, other windows by ClipByPolygon(). Products are computed on 64 bit raw
+ * values, so pixel coordinates do not overflow fixed point. If result
+ * does not fit POLYCLIP_MAX_POINTS, polygon is replaced by its bounding
+ * box, which is larger, so visibility stays conservative.
+ */
+class ScreenPolygon
+{
+public:
+
+	/// Default constructor. Creates empty polygon.
+	ScreenPolygon() { count=0; }
+
+	/// Removes all points.
+	inline void Clear() { count=0; }
+
+	/// Checks if polygon has no area.
+	inline Bool IsEmpty() const { return count<3; }
+
+	/// Adds point.
+	/**
+	 * @return Returns False if polygon is full.
+	 */
+	inline Bool Add(const Point& point)
+	{
+		if(count==POLYCLIP_MAX_POINTS)
+			return False;
+
+		p[count++]=point;
+		return True;
+	}
+
+	/// Sets polygon to rectangle.
+	inline void SetRect(Fixed x1,Fixed y1,Fixed x2,Fixed y2)
+	{
+		p[0]=Point(x1,y1);
+		p[1]=Point(x2,y1);
+		p[2]=Point(x2,y2);
+		p[3]=Point(x1,y2);
+		count=4;
+	}
+
+	/// Returns bounding box.
+	void GetBounds(Fixed& x1,Fixed& y1,Fixed& x2,Fixed& y2) const
+	{
+		x1=x2=p[0].x;
+		y1=y2=p[0].y;
+
+		for(Int i=1;i<count;i++)
+		{
+			if(p[i].x<x1) x1=p[i].x;
+			if(p[i].x>x2) x2=p[i].x;
+			if(p[i].y<y1) y1=p[i].y;
+			if(p[i].y>y2) y2=p[i].y;
+		}
+	}
+
+	/// Returns pixels covered by polygon, for scissoring.
+	/**
+	 * @param r - receives inclusive bounds, rounded outwards.
+	 */
+	void GetBounds(ClipRect& r) const
+	{
+		Fixed x1,y1,x2,y2;
+		GetBounds(x1,y1,x2,y2);
+
+		r.x1=x1.value>>16;
+		r.y1=y1.value>>16;
+		r.x2=((x2.value+0xffff)>>16)-1;
+		r.y2=((y2.value+0xffff)>>16)-1;
+	}
+
+	/// Checks if polygon is axis aligned rectangle.
+	Bool IsRect() const
+	{
+		if(count!=4)
+			return False;
+
+		for(Int i=0;i<4;i++)
+		{
+			const Point& a=p[i];
+			const Point& b=p[(i+1)&3];
+
+			if(abs(a.x-b.x)>POLYCLIP_EPSILON && abs(a.y-b.y)>POLYCLIP_EPSILON)
+				return False;
+		}
+
+		return True;
+	}
+
+	/// Leaves part of polygon inside rectangle.
+	/**
+	 * @return Returns False if nothing is left.
+	 */
+	Bool ClipByRect(Fixed x1,Fixed y1,Fixed x2,Fixed y2)
+	{
+		return ClipAxis(0,x1,True) &&
+			   ClipAxis(0,x2,False) &&
+			   ClipAxis(1,y1,True) &&
+			   ClipAxis(1,y2,False);
+	}
+
+	/// Leaves part of polygon inside pixel rectangle.
+	/**
+	 * Right and bottom pixels are included, so polygon is clipped at x2+1, y2+1.
+	 * @return Returns False if nothing is left.
+	 */
+	inline Bool ClipByRect(const ClipRect& r)
+	{
+		return ClipByRect(Fixed(r.x1),Fixed(r.y1),Fixed(r.x2+1),Fixed(r.y2+1));
+	}
+
+	/// Leaves part of polygon inside convex window of any orientation.
+	/**
+	 * @return Returns False if nothing is left.
+	 */
+	Bool ClipByPolygon(const ScreenPolygon& w)
+	{
+		if(w.IsEmpty())
+		{
+			count=0;
+			return False;
+		}
+
+		Long orient=w.GetArea2()>=0 ? 1 : -1;
+
+		for(Int i=0;i<w.count && !IsEmpty();i++)
+		{
+			const Point& a=w.p[i];
+			const Point& b=w.p[(i+1)%w.count];
+
+			Long ex=(Long)b.x.value-a.x.value;
+			Long ey=(Long)b.y.value-a.y.value;
+
+			if(!ex && !ey)
+				continue;
+
+			ClipEdge(a,ex*orient,ey*orient);
+		}
+
+		return !IsEmpty();
+	}
+
+	/// Returns doubled signed area in raw fixed units, positive for counter clockwise order.
+	Long GetArea2() const
+	{
+		Long area=0;
+
+		for(Int i=0;i<count;i++)
+		{
+			const Point& a=p[i];
+			const Point& b=p[(i+1)%count];
+
+			area+=( (Long)a.x.value*b.y.value-(Long)b.x.value*a.y.value )>>16;
+		}
+
+		return area;
+	}
+
+	/// Points.
+	Point p[POLYCLIP_MAX_POINTS];
+
+	/// Number of points.
+	Int count;
+
+private:
+
+	/// Keeps side of line x or y = value.
+	/**
+	 * @param axis - 0 for x, 1 for y.
+	 * @param value - line coordinate.
+	 * @param greater - True to keep points with coordinate not less than value.
+	 */
+	Bool ClipAxis(Int axis,Fixed value,Bool greater)
+	{
+		if(IsEmpty())
+			return False;
+
+		ScreenPolygon r;
+
+		for(Int i=0;i<count;i++)
+		{
+			const Point& a=p[i];
+			const Point& b=p[(i+1)%count];
+
+			Long da=(Long)(axis ? a.y.value : a.x.value)-value.value;
+			Long db=(Long)(axis ? b.y.value : b.x.value)-value.value;
+
+			if(!greater)
+			{
+				da=-da;
+				db=-db;
+			}
+
+			if(da>=0 && !r.AddUnique(a))
+				return SetBoundsAndClipAxis(axis,value,greater);
+
+			if((da<0)!=(db<0))
+			{
+				Double t=(Double)da/(Double)(da-db);
+
+				Point q;
+				if(axis)
+				{
+					q.y=value;
+					q.x.value=a.x.value+(Int)( (Double)((Long)b.x.value-a.x.value)*t );
+				}
+				else
+				{
+					q.x=value;
+					q.y.value=a.y.value+(Int)( (Double)((Long)b.y.value-a.y.value)*t );
+				}
+
+				if(!r.AddUnique(q))
+					return SetBoundsAndClipAxis(axis,value,greater);
+			}
+		}
+
+		*this=r;
+		return !IsEmpty();
+	}
+
+	/// Keeps left side of edge starting at a with direction (ex,ey).
+	void ClipEdge(const Point& a,Long ex,Long ey)
+	{
+		ScreenPolygon r;
+		Long dx[POLYCLIP_MAX_POINTS];
+		Long dy[POLYCLIP_MAX_POINTS];
+		Long d[POLYCLIP_MAX_POINTS];
+
+		// Products are kept in 64 bits by scaling down only values which
+		// need it, so short edges keep their exact direction.
+		Long m=0;
+		for(Int i=0;i<count;i++)
+		{
+			dx[i]=(Long)p[i].x.value-a.x.value;
+			dy[i]=(Long)p[i].y.value-a.y.value;
+			m|=dx[i]<0 ? -dx[i] : dx[i];
+			m|=dy[i]<0 ? -dy[i] : dy[i];
+		}
+
+		Int sd=0;
+		while((m>>sd)>=((Long)1<<32))
+			sd++;
+
+		m=( ex<0 ? -ex : ex )|( ey<0 ? -ey : ey );
+
+		Int se=0;
+		while((m>>se)>=((Long)1<<30))
+			se++;
+
+		ex>>=se;
+		ey>>=se;
+
+		for(Int i=0;i<count;i++)
+			d[i]=ex*(dy[i]>>sd)-ey*(dx[i]>>sd);
+
+		for(Int i=0;i<count;i++)
+		{
+			Int j=(i+1)%count;
+
+			if(d[i]>=0 && !r.AddUnique(p[i]))
+			{
+				SetBoundsAndClipEdge(a,ex,ey);
+				return;
+			}
+
+			if((d[i]<0)!=(d[j]<0))
+			{
+				Double t=(Double)d[i]/(Double)(d[i]-d[j]);
+
+				Point q;
+				q.x.value=p[i].x.value+(Int)( (Double)(dx[j]-dx[i])*t );
+				q.y.value=p[i].y.value+(Int)( (Double)(dy[j]-dy[i])*t );
+
+				if(!r.AddUnique(q))
+				{
+					SetBoundsAndClipEdge(a,ex,ey);
+					return;
+				}
+			}
+		}
+
+		*this=r;
+	}
+
+	/// Replaces polygon by bounding box and clips it by edge, box is larger so visibility stays conservative.
+	void SetBoundsAndClipEdge(const Point& a,Long ex,Long ey)
+	{
+		Fixed x1,y1,x2,y2;
+		GetBounds(x1,y1,x2,y2);
+		SetRect(x1,y1,x2,y2);
+		ClipEdge(a,ex,ey);
+	}
+
+	/// Replaces polygon by bounding box and clips it by line.
+	Bool SetBoundsAndClipAxis(Int axis,Fixed value,Bool greater)
+	{
+		Fixed x1,y1,x2,y2;
+		GetBounds(x1,y1,x2,y2);
+		SetRect(x1,y1,x2,y2);
+		return ClipAxis(axis,value,greater);
+	}
+
+	/// Adds point unless it repeats previous one.
+	inline Bool AddUnique(const Point& point)
+	{
+		if(count && p[count-1].x.value==point.x.value && p[count-1].y.value==point.y.value)
+			return True;
+
+		return Add(point);
+	}
+};
+
+/// Clips polygon by convex window without heap allocation.
+/** \relates ScreenPolygon
+ *	Fast path for rectangular window or polygon, general clipping otherwise.
+ *	@param P - polygon, receives result.
+ *	@param W - convex window.
+ *	@return Returns False if nothing is left.
+ */
+inline Bool Clipping(ScreenPolygon& P,const ScreenPolygon& W)
+{
+	Fixed x1,y1,x2,y2;
+
+	if(W.IsRect())
+	{
+		W.GetBounds(x1,y1,x2,y2);
+		return P.ClipByRect(x1,y1,x2,y2);
+	}
+
+	// Intersection is the same if rectangle clips window.
+	if(P.IsRect())
+	{
+		P.GetBounds(x1,y1,x2,y2);
+		P=W;
+		return P.ClipByRect(x1,y1,x2,y2);
+	}
+
+	return P.ClipByPolygon(W);
+}
+
 class Plane
 {
 public:
@@ -131,6 +131,12 @@ public:
 	 */
 	void SetBorder(const Fixed * border_);
 
+	/// Returns portal's border.
+	/**
+	 * @return Returns array of four border vertexes.
+	 */
+	inline const Vector3fx* GetBorder() { return border; }
+
 	/// Returns Min value of portal's BoundingBox.
 	/**
 	 * @return Returns Min value of portal's BoundingBox.
@@ -365,6 +371,84 @@ ObjRef<Portal> FindCrossPortal(ObjRef<Room> room, const Vector3fx &pos, const Fi
 
 void SortAndBuildLightMap(Render3D *render, vector< ObjRef<Basic3D> >& b3d_list, const Char *file_name_prefix);
 
+/// Adds references of scene node to graph, walks its parent and children.
+/** \relates ObjectGraph
+ *	Children of Object3D and nodes of Actor3D are walked, other node
+ *	classes add only parent reference.
+ *	@param graph - graph to fill.
+ *	@param object - scene node.
+ */
+inline void AddNodeReferences(ObjectGraph& graph, ObjRef<Basic3D> object)
+{
+	Basic3D* b = object;
+	if( !b || !graph.Visit( b ) )
+		return;
+
+	ObjRef<Basic3D> parent = b->GetParent();
+	graph.AddReference( b, parent );
+	AddNodeReferences( graph, parent );
+
+	vector< ObjRef<Basic3D> >* children = NULL;
+
+	if( b->GetClassID() == ClassID_Object3D )
+	{
+		Object3D* o = static_cast<Object3D*>( b );
+		graph.AddReference( b, o->vb );
+		graph.AddReference( b, o->lmp );
+		children = &o->children;
+	}
+	else
+	if( b->GetClassID() == ClassID_Actor3D )
+		children = &static_cast<Actor3D*>( b )->nodes;
+
+	if( !children )
+		return;
+
+	graph.AddReferences( b, *children );
+	for( Int i = 0; i < (Int)children->size(); i++ )
+		AddNodeReferences( graph, (*children)[i] );
+}
+
+/// Adds references of room to graph, walks linked portals, rooms and objects.
+/** \relates ObjectGraph
+ *	Call for every room of level on teardown, after level's own references
+ *	are dropped, then ObjectGraph::FindCycles() finds what is not released.
+ *	@param graph - graph to fill.
+ *	@param room - room.
+ */
+inline void AddRoomReferences(ObjectGraph& graph, ObjRef<Room> room)
+{
+	Room* r = room;
+	if( !r || !graph.Visit( r ) )
+		return;
+
+	graph.AddReferences( r, r->grounds );
+	graph.AddReferences( r, r->portals );
+	graph.AddReferences( r, r->b3d_list );
+
+	for( Int i = 0; i < (Int)r->portals.size(); i++ )
+	{
+		Portal* p = r->portals[i];
+		if( !p || !graph.Visit( p ) )
+			continue;
+
+		ObjRef<Room> room_a = p->GetRoomA();
+		ObjRef<Room> room_b = p->GetRoomB();
+		graph.AddReference( p, room_a );
+		graph.AddReference( p, room_b );
+		graph.AddReferences( p, p->b3d_list );
+
+		for( Int j = 0; j < (Int)p->b3d_list.size(); j++ )
+			AddNodeReferences( graph, p->b3d_list[j] );
+
+		AddRoomReferences( graph, room_a );
+		AddRoomReferences( graph, room_b );
+	}
+
+	for( Int i = 0; i < (Int)r->b3d_list.size(); i++ )
+		AddNodeReferences( graph, r->b3d_list[i] );
+}
+
 } //namespace mdragon
 
 #endif // __MD_PORTAL_H__
\ No newline at end of file
@@ -0,0 +1,346 @@
+/** \file
+ *	Frame coherent portal traversal cache. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_PORTALCACHE_H__
+#define __MD_PORTALCACHE_H__
+
+namespace mdragon
+{
+
+/// Default camera move along any axis that invalidates PortalCache, in world units.
+#define PortalCache_Move_Threshold		Fixed( 1 )
+
+/// Default cosine of camera turn angle that invalidates PortalCache, about 6 degrees.
+#define PortalCache_Turn_Threshold		Fixed( 0.995f )
+
+/// Default radius of sphere checked for crossing portals, see FindCrossPortal().
+#define PortalCache_Cross_Radius		Fixed( 10 )
+
+
+/// Keeps result of portal traversal between frames.
+/**
+ *	Replaces per frame FindStartRoom() and DrawFromRoom() calls. Start room
+ *	is searched by FindRoomAround() from last room and last visible rooms
+ *	before scanning all rooms. Portals are projected and clipped by
+ *	CheckNearRooms() every frame. While camera stays in the same room and
+ *	moves and turns less than thresholds, traversal is limited to rooms
+ *	found visible by last full traversal: portals leading out of them
+ *	are marked checked, see RoomPVS::Cull() for how CheckNearRooms()
+ *	honors the flags. Room coming into view at portal edge is drawn only
+ *	after camera passes threshold, thresholds 0 and F_ONE make result
+ *	exact but give hits only for still camera. <br>
+ *	Checked flags are changed incrementally: frame reverts only flags
+ *	set by the cache and rooms found by last traversal, not all rooms.
+ *	Flags belong to the cache between Update() calls, call Invalidate()
+ *	if other code traverses portals of the same rooms.
+ */
+class PortalCache
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( PortalCache, MemoryTag_Render3D )
+
+	/// Constructor.
+	PortalCache()
+	{
+		pvs = NULL;
+		move_threshold = PortalCache_Move_Threshold;
+		turn_threshold = PortalCache_Turn_Threshold;
+		cross_radius = PortalCache_Cross_Radius;
+		valid = False;
+		flags_known = False;
+		pvs_marked = False;
+		frontier_marked = False;
+		hits = misses = 0;
+	}
+
+	/// Sets camera change that invalidates cache.
+	/**
+	 *	@param move - move along any axis, 0 invalidates on any move.
+	 *	@param turn_cos - cosine of turn angle, F_ONE invalidates on any turn.
+	 */
+	inline void SetThresholds( const Fixed& move, const Fixed& turn_cos )
+	{
+		move_threshold = move;
+		turn_threshold = turn_cos;
+		valid = False;
+	}
+
+	/// Sets radius of sphere checked for crossing portals.
+	inline void SetCrossRadius( const Fixed& radius ) { cross_radius = radius; }
+
+	/// Sets baked visible sets used to skip rooms before traversal, NULL to disable.
+	inline void SetPVS( RoomPVS* pvs_ ) { pvs = pvs_; valid = False; flags_known = False; }
+
+	/// Forces traversal on next Update(), call after rooms or portals change.
+	inline void Invalidate() { valid = False; flags_known = False; }
+
+	/// Finds room with camera.
+	/**
+	 *	Tries FindRoomAround() from last room and last visible rooms, then
+	 *	FindStartRoom(). If camera is out of all rooms last room is kept.
+	 *	@param pos - camera position.
+	 *	@param rooms - all rooms.
+	 *	@return Returns room, NULL if camera was never in room.
+	 */
+	ObjRef<Room> FindRoom( const Vector3fx& pos, vector< ObjRef<Room> >& rooms )
+	{
+		ObjRef<Room> found;
+
+		if( room )
+			found = FindRoomAround( pos, room );
+
+		for( Int i = 0; !found && i < (Int)vis_rooms.size(); i++ )
+			if( vis_rooms[i] != room )
+				found = FindRoomAround( pos, vis_rooms[i] );
+
+		if( !found )
+			found = FindStartRoom( pos, rooms );
+
+		if( found )
+			room = found;
+
+		return room;
+	}
+
+	/// Finds visible rooms, limiting traversal to last visible rooms if camera changed little.
+	/**
+	 *	@param pos - camera position.
+	 *	@param dir - camera direction, normalized, see Camera::GetDir().
+	 *	@param rooms - all rooms.
+	 *	@return Returns False if camera was never in room.
+	 */
+	Bool Update( const Vector3fx& pos, const Vector3fx& dir, vector< ObjRef<Room> >& rooms )
+	{
+		ObjRef<Room> start = FindRoom( pos, rooms );
+		if( !start )
+		{
+			valid = False;
+			return False;
+		}
+
+		// Near portal both rooms are visible, traversal from one room misses the other.
+		cross_portal = FindCrossPortal( start, pos, cross_radius );
+		if( cross_portal )
+		{
+			// DrawPortal() traverses with its own flags.
+			valid = False;
+			flags_known = False;
+			return True;
+		}
+
+		Bool hit = valid && start == last_start && !IsMoved( pos, dir );
+
+		if( hit )
+		{
+			hits++;
+
+			// Rooms found by last traversal are marked by CheckNearRooms().
+			for( Int i = 0; i < (Int)vis_rooms.size(); i++ )
+				vis_rooms[i]->SetChecked( False );
+
+			if( !frontier_marked )
+				MarkFrontier();
+		}
+		else
+		{
+			misses++;
+			ResetChecked( rooms );
+
+			if( pvs )
+			{
+				pvs->Cull( start, rooms );
+				pvs_marked = True;
+			}
+		}
+
+		vis_rooms.clear();
+		CheckNearRooms( start, ObjRef<Portal>(), vis_rooms );
+
+		vis_portals.clear();
+		for( Int i = 0; i < (Int)vis_rooms.size(); i++ )
+		{
+			vector< ObjRef<Portal> >& portals = vis_rooms[i]->portals;
+
+			for( Int k = 0; k < (Int)portals.size(); k++ )
+				if( portals[k]->IsVisible() && portals[k]->b3d_list.size() &&
+					find( vis_portals.begin(), vis_portals.end(), portals[k] ) == vis_portals.end() )
+					vis_portals.push_back( portals[k] );
+		}
+
+		if( !hit )
+		{
+			cached_rooms = vis_rooms;
+			cached_index.clear();
+			for( Int i = 0; i < (Int)cached_rooms.size(); i++ )
+				cached_index.insert( (const Room*)cached_rooms[i], i );
+
+			last_start = start;
+			last_pos = pos;
+			last_dir = dir;
+			valid = True;
+		}
+
+		return True;
+	}
+
+	/// Draws rooms found by last Update().
+	/**
+	 *	@param rooms - all rooms, used when camera is crossing portal.
+	 */
+	void Draw( vector< ObjRef<Room> >& rooms )
+	{
+		if( cross_portal )
+		{
+			DrawPortal( cross_portal, rooms );
+			return;
+		}
+
+		RENDER3D_PROFILE_SCOPE( Render3D_Stage_Submit )
+
+		for( Int i = 0; i < (Int)vis_rooms.size(); i++ )
+			vis_rooms[i]->Draw();
+
+		for( Int i = 0; i < (Int)vis_portals.size(); i++ )
+			vis_portals[i]->Draw();
+	}
+
+	/// Returns room with camera.
+	inline ObjRef<Room> GetRoom() { return room; }
+
+	/// Returns rooms found visible by last Update().
+	inline const vector< ObjRef<Room> >& GetVisibleRooms() { return vis_rooms; }
+
+	/// Returns number of Update() calls that traversed only last visible rooms.
+	inline DWord GetHitCount() { return hits; }
+
+	/// Returns number of Update() calls that traversed all rooms.
+	inline DWord GetMissCount() { return misses; }
+
+private:
+
+	/// Checks if camera changed more than thresholds since last traversal.
+	Bool IsMoved( const Vector3fx& pos, const Vector3fx& dir )
+	{
+		Vector3fx d = pos - last_pos;
+
+		if( abs( d.x ) > move_threshold || abs( d.y ) > move_threshold || abs( d.z ) > move_threshold )
+			return True;
+
+		// Dot product of normalized fixed point vector with itself may be less than one.
+		if( turn_threshold >= F_ONE )
+			return dir.x != last_dir.x || dir.y != last_dir.y || dir.z != last_dir.z;
+
+		return DotProduct( dir, last_dir ) < turn_threshold;
+	}
+
+	/// Marks portals leading out of last full traversal result as checked.
+	/**
+	 *	Traversal from start room reaches other rooms only through them.
+	 */
+	void MarkFrontier()
+	{
+		for( Int i = 0; i < (Int)cached_rooms.size(); i++ )
+		{
+			Room* room = cached_rooms[i];
+
+			for( Int k = 0; k < (Int)room->portals.size(); k++ )
+			{
+				Portal* portal = room->portals[k];
+				if( portal->IsChecked() )
+					continue;
+
+				ObjRef<Room> a = portal->GetRoomA();
+				ObjRef<Room> b = portal->GetRoomB();
+				ObjRef<Room> other = (Room*)a == room ? b : a;
+
+				if( !other || !cached_index.count( (const Room*)other ) )
+				{
+					portal->SetChecked( True );
+					marked_portals.push_back( portal );
+				}
+			}
+		}
+
+		frontier_marked = True;
+	}
+
+	/// Clears checked flags before full traversal.
+	/**
+	 *	Reverts only portals marked by MarkFrontier() and rooms found by last
+	 *	traversal, unless flags were changed by RoomPVS::Cull() or are unknown.
+	 */
+	void ResetChecked( vector< ObjRef<Room> >& rooms )
+	{
+		if( !flags_known || pvs_marked )
+			RoomPVS::ClearChecked( rooms );
+		else
+		{
+			for( Int i = 0; i < (Int)marked_portals.size(); i++ )
+				marked_portals[i]->SetChecked( False );
+
+			for( Int i = 0; i < (Int)vis_rooms.size(); i++ )
+				vis_rooms[i]->SetChecked( False );
+		}
+
+		marked_portals.clear();
+		frontier_marked = False;
+		pvs_marked = False;
+		flags_known = True;
+	}
+
+	PortalCache( const PortalCache& );
+	PortalCache& operator = ( const PortalCache& );
+
+	RoomPVS* pvs;
+
+	Fixed move_threshold;
+	Fixed turn_threshold;
+	Fixed cross_radius;
+
+	/// Room with camera.
+	ObjRef<Room> room;
+
+	/// Portal camera is crossing, drawn by DrawPortal().
+	ObjRef<Portal> cross_portal;
+
+	/// Traversal start room and camera.
+	ObjRef<Room> last_start;
+	Vector3fx last_pos;
+	Vector3fx last_dir;
+	Bool valid;
+
+	/// Rooms found visible by last full traversal.
+	vector< ObjRef<Room> > cached_rooms;
+
+	/// Indexes of cached_rooms.
+	hash_map<const Room*, Int> cached_index;
+
+	/// Portals marked checked by MarkFrontier().
+	vector< ObjRef<Portal> > marked_portals;
+
+	/// False if flags may be changed outside of cache, ResetChecked() clears all then.
+	Bool flags_known;
+
+	/// Flags were changed by RoomPVS::Cull() since last ResetChecked().
+	Bool pvs_marked;
+
+	/// MarkFrontier() was done for cached_rooms.
+	Bool frontier_marked;
+
+	vector< ObjRef<Room> > vis_rooms;
+
+	/// Visible portals having objects.
+	vector< ObjRef<Portal> > vis_portals;
+
+	DWord hits;
+	DWord misses;
+};
+
+} //namespace mdragon
+
+#endif // __MD_PORTALCACHE_H__
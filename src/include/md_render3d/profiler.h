@@ -0,0 +1,205 @@
+/** \file
+ *	Render3D pipeline profiler. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_RENDER3D_PROFILER_H__
+#define __MD_RENDER3D_PROFILER_H__
+
+/*
+ *	Profiling is compiled in debug builds or if MD_RENDER3D_PROFILE is
+ *	defined in project settings. In release builds all RENDER3D_PROFILE_XXX
+ *	macros are empty. Render3DProfiler is not part of Render3D, so its
+ *	layout does not depend on these settings.
+ */
+#if defined(MD_TL_DEBUG) && !defined(MD_RENDER3D_PROFILE)
+#define MD_RENDER3D_PROFILE
+#endif
+
+namespace mdragon
+{
+
+/* Render3D pipeline stages. */
+
+/// Vertex transformation and projection, see TransformVertexBatch().
+#define Render3D_Stage_Transform	0
+
+/// Vertex buffer morphing, see MorphVertexBuffer().
+#define Render3D_Stage_Morph		1
+
+/// Sorting of triangles, see DepthSorter.
+#define Render3D_Stage_Sort			2
+
+/// Hierarchical Z-buffer update, see HiZBuffer.
+#define Render3D_Stage_Occlusion	3
+
+/// Render3D::Flush() called by MD_BENCH_FLUSH().
+#define Render3D_Stage_Flush		4
+
+/// Render3D::Show() called by MD_BENCH_SHOW().
+#define Render3D_Stage_Show			5
+
+/// Draw queue submission by header code, see PortalCache::Draw().
+#define Render3D_Stage_Submit		6
+
+/// Number of stages.
+#define Render3D_Stage_Count		7
+
+/// Number of frames stored by Render3DProfiler.
+#define Render3D_Profile_Frames		64
+
+
+/// Render3D pipeline statistics for one frame.
+class Render3DFrameProfile
+{
+public:
+
+	/// Time spent in each stage in microseconds, see Render3D_Stage_XXX defines.
+	DWord stage_ticks[Render3D_Stage_Count];
+
+	/// Vertices transformed by TransformVertexBatch().
+	DWord vertices_transformed;
+
+	/// Vertices morphed by MorphVertexBuffer().
+	DWord vertices_morphed;
+
+	/// Triangles sorted by DepthSorter.
+	DWord triangles_sorted;
+
+	/// Frame number.
+	DWord frame;
+};
+
+
+/// Collects Render3DFrameProfile for the last Render3D_Profile_Frames frames.
+/**
+ *	RENDER3D_PROFILE_XXX macros write to the global profiler returned by
+ *	Instance(). Frame ends in MD_BENCH_SHOW(), or application ends it with
+ *	RENDER3D_PROFILE_END_FRAME. <br>
+ *	Render3D::Flush(), Render3D::Show() and Object3D::Draw() are library
+ *	code, so their inner stages (clipping, lighting, rasterization) are not
+ *	seen separately. Flush and Show stages measure whole calls made through
+ *	MD_BENCH_FLUSH() and MD_BENCH_SHOW().
+ */
+class Render3DProfiler
+{
+public:
+
+	/// Constructor.
+	Render3DProfiler() { Reset(); }
+
+	/// Returns global profiler.
+	static Render3DProfiler& Instance()
+	{
+		static Render3DProfiler profiler;
+		return profiler;
+	}
+
+	/// Clears all collected frames.
+	void Reset()
+	{
+		memset( &current, 0, sizeof(current) );
+		memset( &total, 0, sizeof(total) );
+		head = 0;
+		count = 0;
+	}
+
+	/// Returns statistics of frame being drawn.
+	inline Render3DFrameProfile& Current() { return current; }
+
+	/// Stores current frame statistics and starts new frame.
+	/**
+	 *	Call once per frame, for example after Render3D::Show().
+	 */
+	void EndFrame()
+	{
+		frames[head] = current;
+		head = ( head + 1 ) % Render3D_Profile_Frames;
+		if( count < Render3D_Profile_Frames )
+			count++;
+
+		for( Int i = 0; i < Render3D_Stage_Count; i++ )
+			total.stage_ticks[i] += current.stage_ticks[i];
+
+		total.vertices_transformed += current.vertices_transformed;
+		total.vertices_morphed += current.vertices_morphed;
+		total.triangles_sorted += current.triangles_sorted;
+		total.frame++;
+
+		DWord frame = current.frame + 1;
+		memset( &current, 0, sizeof(current) );
+		current.frame = frame;
+	}
+
+	/// Returns number of stored frames.
+	inline Int GetFrameCount() { return count; }
+
+	/// Returns stored frame statistics.
+	/**
+	 *	@param age - 0 for last finished frame, GetFrameCount() - 1 for oldest.
+	 */
+	inline const Render3DFrameProfile& GetFrame( Int age )
+	{
+		assert( age >= 0 && age < count );
+		return frames[ ( head + Render3D_Profile_Frames - 1 - age ) % Render3D_Profile_Frames ];
+	}
+
+	/// Returns sum of all frames finished since Reset().
+	/**
+	 *	Field frame holds number of finished frames.
+	 */
+	inline const Render3DFrameProfile& GetTotal() { return total; }
+
+private:
+
+	Render3DFrameProfile current;
+	Render3DFrameProfile total;
+	Render3DFrameProfile frames[Render3D_Profile_Frames];
+	Int head;
+	Int count;
+};
+
+
+/// Adds time spent in scope to one stage of current frame.
+class Render3DProfileScope
+{
+public:
+
+	inline Render3DProfileScope( Render3DProfiler& profiler_, Int stage_ )
+		: profiler( profiler_ ), stage( stage_ )
+	{
+		ticks = GetMicroTickCount();
+	}
+
+	inline ~Render3DProfileScope()
+	{
+		profiler.Current().stage_ticks[stage] += GetMicroTickCount() - ticks;
+	}
+
+private:
+
+	Render3DProfiler& profiler;
+	Int stage;
+	DWord ticks;
+};
+
+
+#ifdef MD_RENDER3D_PROFILE
+
+#define RENDER3D_PROFILE_SCOPE(stage) mdragon::Render3DProfileScope render3d_profile_scope_##stage( mdragon::Render3DProfiler::Instance(), (stage) );
+#define RENDER3D_PROFILE_COUNT(counter,n) ( mdragon::Render3DProfiler::Instance().Current().counter += (n) );
+#define RENDER3D_PROFILE_END_FRAME() mdragon::Render3DProfiler::Instance().EndFrame();
+
+#else
+
+#define RENDER3D_PROFILE_SCOPE(stage)
+#define RENDER3D_PROFILE_COUNT(counter,n)
+#define RENDER3D_PROFILE_END_FRAME()
+
+#endif
+
+} //namespace mdragon
+
+#endif // __MD_RENDER3D_PROFILER_H__
@@ -0,0 +1,706 @@
+/** \file
+ *	Potentially visible sets of portal system rooms. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_PVS_H__
+#define __MD_PVS_H__
+
+namespace mdragon
+{
+
+/// Signature of RoomPVS data, "PVS1".
+#define RoomPVS_Signature		0x31535650UL
+
+/// Maximal number of portals passed by one line of sight in RoomPVS::Bake().
+#define RoomPVS_Max_Depth		64
+
+/// Maximal number of points in clipped portal polygon.
+#define RoomPVS_Max_Points		40
+
+/// Distance treated as zero by RoomPVS::Bake(), in world units.
+#define RoomPVS_Epsilon			0.01f
+
+
+/// Portal polygon used by RoomPVS::Bake().
+class RoomPVSWinding
+{
+public:
+
+	/// Number of points.
+	Int count;
+
+	/// Points.
+	Float p[RoomPVS_Max_Points][3];
+};
+
+
+/// Plane used by RoomPVS::Bake(), front side is dot( n, p ) >= d.
+class RoomPVSPlane
+{
+public:
+
+	Float n[3];
+	Float d;
+
+	/// Returns signed distance to point.
+	inline Float Distance( const Float* p ) const { return n[0] * p[0] + n[1] * p[1] + n[2] * p[2] - d; }
+
+	/// Turns plane to opposite side.
+	inline void Flip() { n[0] = -n[0]; n[1] = -n[1]; n[2] = -n[2]; d = -d; }
+};
+
+
+/// Room to room potentially visible sets.
+/**
+ *	For every room of MDMLoad::rooms keeps bitset of rooms that may be
+ *	seen from any point of it. Bake() computes it offline by clipping
+ *	portal chains to lines of sight passing all of them, so result is
+ *	conservative: every room that can be seen is in the set. Baked data is
+ *	stored by Write() to side file and loaded by Read().
+ *
+ *	Bake() first floods from every portal through portals in front of it.
+ *	The rooms reached are all that portal may ever show. Chains whose
+ *	portals together may show no room not found yet are not clipped.
+ *	Chains longer than RoomPVS_Max_Depth portals are not clipped either:
+ *	all rooms reachable behind them are added.
+ *
+ *	At runtime Cull() is called before CheckNearRooms(): rooms outside the
+ *	set of start room and portals leading to them are marked checked, so
+ *	portal traversal does not project and clip them and exact portal
+ *	clipping is left only for candidates. <br>
+ *	CheckNearRooms() of the engine library skips portals marked checked
+ *	before it projects them, and clears only flags it set itself, so
+ *	portals marked by Cull() stay closed for whole traversal. Checked flag
+ *	of room only keeps it out of visible list, its portals are still
+ *	walked. So Cull() relies on portal flags, a room is hidden because
+ *	all its portals are marked.
+ */
+class RoomPVS
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( RoomPVS, MemoryTag_Render3D )
+
+	/// Constructor.
+	RoomPVS()
+	{
+		room_count = 0;
+		row_size = 0;
+		names_hash = 0;
+	}
+
+	/// Computes sets for rooms.
+	/**
+	 *	Rooms are numbered by position in list. Slow, call it from tools
+	 *	and save result by Write().
+	 *	@param rooms - rooms, usually MDMLoad::rooms.
+	 */
+	void Bake( vector< ObjRef<Room> >& rooms )
+	{
+		SetRooms( rooms );
+
+		bits.clear();
+		bits.resize( room_count * row_size, 0 );
+
+		BakeMightSee( rooms );
+		masks.resize( ( RoomPVS_Max_Depth + 2 ) * row_size );
+
+		vector<Int> path;
+
+		for( Int a = 0; a < room_count; a++ )
+		{
+			Room* room = rooms[a];
+			Set( a, a );
+
+			for( Int i = 0; i < (Int)room->portals.size(); i++ )
+			{
+				Portal* source = room->portals[i];
+				Room* next = GetOtherRoom( source, room );
+				Int n = GetIndex( next );
+				if( n < 0 )
+					continue;
+
+				Set( a, n );
+
+				// Nothing is seen behind dead end room.
+				if( next->portals.size() < 2 )
+					continue;
+
+				RoomPVSWinding w;
+				RoomPVSPlane plane;
+				GetWinding( source, w );
+
+				if( !GetPortalPlane( w, source, next, plane ) )
+				{
+					// Direction through portal is unknown, every room behind it may be seen.
+					Flood( GetRow( a ), next, source, NULL );
+					continue;
+				}
+
+				path.clear();
+				path.push_back( a );
+				path.push_back( n );
+				Bake( a, next, source, w, plane, w, GetMightSee( a, i ), path );
+			}
+		}
+
+		might_see.clear();
+		might_first.clear();
+		masks.clear();
+	}
+
+	/// Returns number of rooms.
+	inline Int GetRoomCount() { return room_count; }
+
+	/// Returns room index, or -1 for unknown room.
+	inline Int GetIndex( const Room* room )
+	{
+		hash_map<const Room*, Int>::iterator i = index.find( room );
+		return i != index.end() ? i->second : -1;
+	}
+
+	/// Checks if room may be seen from another one.
+	/**
+	 *	@param from - index of room with camera.
+	 *	@param to - index of checked room.
+	 *	@return Returns True if room is in set of from room.
+	 */
+	inline Bool IsVisible( Int from, Int to )
+	{
+		return ( bits[ from * row_size + ( to >> 5 ) ] >> ( to & 31 ) ) & 1;
+	}
+
+	/// Checks if room may be seen from another one.
+	/**
+	 *	@return Returns True if room is in set of from room, or if any room is unknown.
+	 */
+	inline Bool IsVisible( const Room* from, const Room* to )
+	{
+		Int f = GetIndex( from );
+		Int t = GetIndex( to );
+		return f < 0 || t < 0 || IsVisible( f, t );
+	}
+
+	/// Marks rooms that can not be seen from start room as checked.
+	/**
+	 *	Call it after checked flags of rooms and portals are cleared, for
+	 *	example by ClearChecked(), and before CheckNearRooms(). Portals of
+	 *	hidden rooms are marked too, so traversal does not pass them.
+	 *	@param start_room - room with camera.
+	 *	@param rooms - rooms, the same list as given to Bake() or Read().
+	 *	@return Returns number of rooms left for traversal.
+	 */
+	Int Cull( ObjRef<Room> start_room, vector< ObjRef<Room> >& rooms )
+	{
+		Int from = GetIndex( start_room );
+		if( from < 0 || (Int)rooms.size() != room_count )
+			return rooms.size();
+
+		Int count = 0;
+
+		for( Int i = 0; i < room_count; i++ )
+		{
+			if( IsVisible( from, i ) )
+			{
+				count++;
+				continue;
+			}
+
+			Room* room = rooms[i];
+			room->SetChecked( True );
+
+			for( Int k = 0; k < (Int)room->portals.size(); k++ )
+				room->portals[k]->SetChecked( True );
+		}
+
+		return count;
+	}
+
+	/// Clears checked flags of rooms and their portals.
+	static void ClearChecked( vector< ObjRef<Room> >& rooms )
+	{
+		for( Int i = 0; i < (Int)rooms.size(); i++ )
+		{
+			rooms[i]->SetChecked( False );
+
+			for( Int k = 0; k < (Int)rooms[i]->portals.size(); k++ )
+				rooms[i]->portals[k]->SetChecked( False );
+		}
+	}
+
+	/// Writes sets to resource.
+	/**
+	 *	Data is signature, number of rooms, hash of room names and
+	 *	bitset rows, all DWords.
+	 *	@param res - resource to write to.
+	 *	@return Returns True if written.
+	 */
+	Bool Write( Resource& res )
+	{
+		DWord header[3] = { RoomPVS_Signature, (DWord)room_count, names_hash };
+
+		return res.Write( header, 3 ) && ( !bits.size() || res.Write( bits.begin(), bits.size() ) );
+	}
+
+	/// Reads sets written by Write().
+	/**
+	 *	@param res - resource to read from, for example loaded from PackDir.
+	 *	@param rooms - rooms the sets were baked for.
+	 *	@return Returns False if data is corrupted or baked for other rooms.
+	 */
+	Bool Read( Resource& res, vector< ObjRef<Room> >& rooms )
+	{
+		DWord header[3];
+		if( !res.Read( header, 3 ) || header[0] != RoomPVS_Signature )
+			return False;
+
+		SetRooms( rooms );
+
+		if( header[1] != (DWord)room_count || header[2] != names_hash )
+		{
+			SetRooms( empty_rooms );
+			return False;
+		}
+
+		bits.resize( room_count * row_size );
+		if( bits.size() && !res.Read( bits.begin(), bits.size() ) )
+		{
+			SetRooms( empty_rooms );
+			return False;
+		}
+
+		return True;
+	}
+
+private:
+
+	/// Numbers rooms.
+	void SetRooms( vector< ObjRef<Room> >& rooms )
+	{
+		room_count = rooms.size();
+		row_size = ( room_count + 31 ) >> 5;
+		bits.clear();
+		index.clear();
+		names_hash = 2166136261U;
+
+		for( Int i = 0; i < room_count; i++ )
+		{
+			index.insert( (const Room*)rooms[i], i );
+			names_hash = ( names_hash ^ hash_string( rooms[i]->GetName().c_str() ) ) * 16777619U;
+		}
+	}
+
+	inline void Set( Int from, Int to )
+	{
+		bits[ from * row_size + ( to >> 5 ) ] |= 1UL << ( to & 31 );
+	}
+
+	/// Returns bitset of room.
+	inline DWord* GetRow( Int room ) { return bits.begin() + room * row_size; }
+
+	/// Returns rooms portal of room may show, see BakeMightSee().
+	inline const DWord* GetMightSee( Int room, Int portal ) { return might_see.begin() + ( might_first[room] + portal ) * row_size; }
+
+	/// Floods from every portal of every room into room behind it.
+	/**
+	 *	Only portals with some part in front of first portal are passed,
+	 *	where direction of first portal is unknown all portals are passed.
+	 *	Result is superset of what Bake() can find behind the portal.
+	 */
+	void BakeMightSee( vector< ObjRef<Room> >& rooms )
+	{
+		might_first.resize( room_count + 1 );
+		might_first[0] = 0;
+		for( Int a = 0; a < room_count; a++ )
+			might_first[a + 1] = might_first[a] + (Int)rooms[a]->portals.size();
+
+		might_see.clear();
+		might_see.resize( might_first[room_count] * row_size, 0 );
+
+		for( Int a = 0; a < room_count; a++ )
+		{
+			Room* room = rooms[a];
+
+			for( Int i = 0; i < (Int)room->portals.size(); i++ )
+			{
+				Portal* source = room->portals[i];
+				Room* next = GetOtherRoom( source, room );
+				if( GetIndex( next ) < 0 )
+					continue;
+
+				RoomPVSWinding w;
+				RoomPVSPlane plane;
+				GetWinding( source, w );
+
+				DWord* row = might_see.begin() + ( might_first[a] + i ) * row_size;
+				Flood( row, next, source, GetPortalPlane( w, source, next, plane ) ? &plane : NULL );
+			}
+		}
+	}
+
+	static inline Room* GetOtherRoom( Portal* portal, Room* room )
+	{
+		ObjRef<Room> a = portal->GetRoomA();
+		ObjRef<Room> b = portal->GetRoomB();
+		return (Room*)a == room ? (Room*)b : (Room*)a;
+	}
+
+	static inline Float ToFloat( const Fixed& f ) { return Float( f.value ) / 65536; }
+
+	static void GetWinding( Portal* portal, RoomPVSWinding& w )
+	{
+		const Vector3fx* border = portal->GetBorder();
+
+		w.count = 4;
+		for( Int i = 0; i < 4; i++ )
+		{
+			w.p[i][0] = ToFloat( border[i].x );
+			w.p[i][1] = ToFloat( border[i].y );
+			w.p[i][2] = ToFloat( border[i].z );
+		}
+	}
+
+	/// Computes plane of portal facing into next room.
+	/**
+	 *	Next room side is the side all its other portals lie at.
+	 *	@return Returns False if other portals are at both sides or in
+	 *	portal plane, or if portal is degenerate.
+	 */
+	static Bool GetPortalPlane( const RoomPVSWinding& w, Portal* portal, Room* next, RoomPVSPlane& plane )
+	{
+		// Newell normal, stable for nearly degenerate quads.
+		Float n[3] = { 0, 0, 0 };
+		Float c[3] = { 0, 0, 0 };
+
+		for( Int i = 0; i < w.count; i++ )
+		{
+			const Float* a = w.p[i];
+			const Float* b = w.p[ ( i + 1 ) % w.count ];
+
+			n[0] += ( a[1] - b[1] ) * ( a[2] + b[2] );
+			n[1] += ( a[2] - b[2] ) * ( a[0] + b[0] );
+			n[2] += ( a[0] - b[0] ) * ( a[1] + b[1] );
+
+			c[0] += a[0];
+			c[1] += a[1];
+			c[2] += a[2];
+		}
+
+		if( !Normalize( n ) )
+			return False;
+
+		plane.n[0] = n[0];
+		plane.n[1] = n[1];
+		plane.n[2] = n[2];
+		plane.d = ( n[0] * c[0] + n[1] * c[1] + n[2] * c[2] ) / w.count;
+
+		Bool front = False, back = False;
+
+		for( Int i = 0; i < (Int)next->portals.size(); i++ )
+		{
+			if( (Portal*)next->portals[i] == portal )
+				continue;
+
+			RoomPVSWinding other;
+			GetWinding( next->portals[i], other );
+
+			for( Int k = 0; k < other.count; k++ )
+			{
+				Float d = plane.Distance( other.p[k] );
+				if( d > RoomPVS_Epsilon )
+					front = True;
+				else
+				if( d < -RoomPVS_Epsilon )
+					back = True;
+			}
+		}
+
+		// Portals at both sides, or all in portal plane, give no direction.
+		if( front == back )
+			return False;
+
+		if( back )
+			plane.Flip();
+
+		return True;
+	}
+
+	static Bool Normalize( Float* n )
+	{
+		Float len = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+		if( len < RoomPVS_Epsilon * RoomPVS_Epsilon )
+			return False;
+
+		len = 1 / (Float)MDSqrt( len );
+		n[0] *= len;
+		n[1] *= len;
+		n[2] *= len;
+		return True;
+	}
+
+	/// Leaves part of winding at front side of plane.
+	/**
+	 *	@return Returns False if nothing is left.
+	 */
+	static Bool Clip( RoomPVSWinding& w, const RoomPVSPlane& plane )
+	{
+		Float dist[RoomPVS_Max_Points];
+		Bool back = False;
+
+		for( Int i = 0; i < w.count; i++ )
+		{
+			dist[i] = plane.Distance( w.p[i] );
+			if( dist[i] < -RoomPVS_Epsilon )
+				back = True;
+		}
+
+		if( !back )
+			return True;
+
+		RoomPVSWinding r;
+		r.count = 0;
+
+		for( Int i = 0; i < w.count; i++ )
+		{
+			Int j = ( i + 1 ) % w.count;
+
+			if( dist[i] >= -RoomPVS_Epsilon && r.count < RoomPVS_Max_Points )
+			{
+				r.p[r.count][0] = w.p[i][0];
+				r.p[r.count][1] = w.p[i][1];
+				r.p[r.count][2] = w.p[i][2];
+				r.count++;
+			}
+
+			if( ( dist[i] < -RoomPVS_Epsilon ) != ( dist[j] < -RoomPVS_Epsilon ) && r.count < RoomPVS_Max_Points )
+			{
+				Float t = dist[i] / ( dist[i] - dist[j] );
+				for( Int k = 0; k < 3; k++ )
+					r.p[r.count][k] = w.p[i][k] + ( w.p[j][k] - w.p[i][k] ) * t;
+				r.count++;
+			}
+		}
+
+		if( r.count < 3 )
+			return False;
+
+		w = r;
+		return True;
+	}
+
+	/// Clips target by planes separating source and pass.
+	/**
+	 *	Plane through edge of source and point of pass with source fully at
+	 *	one side and pass at other bounds all lines passing both windings.
+	 *	@param flip - True if source and pass are swapped, target is kept at source side then.
+	 *	@return Returns False if nothing of target is left.
+	 */
+	static Bool ClipToSeparators( const RoomPVSWinding& source, const RoomPVSWinding& pass, RoomPVSWinding& target, Bool flip )
+	{
+		for( Int i = 0; i < source.count; i++ )
+		{
+			const Float* a = source.p[i];
+			const Float* b = source.p[ ( i + 1 ) % source.count ];
+
+			for( Int j = 0; j < pass.count; j++ )
+			{
+				const Float* c = pass.p[j];
+
+				Float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				Float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+				RoomPVSPlane plane;
+				plane.n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+				plane.n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+				plane.n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+				if( !Normalize( plane.n ) )
+					continue;
+
+				plane.d = plane.n[0] * c[0] + plane.n[1] * c[1] + plane.n[2] * c[2];
+
+				// Source must be at back side.
+				Bool front = False, back = False;
+				for( Int k = 0; k < source.count; k++ )
+				{
+					Float d = plane.Distance( source.p[k] );
+					if( d > RoomPVS_Epsilon )
+						front = True;
+					else
+					if( d < -RoomPVS_Epsilon )
+						back = True;
+				}
+
+				if( front && back )
+					continue;
+
+				if( front )
+					plane.Flip();
+
+				// Pass must be at front side.
+				Bool separates = True;
+				for( Int k = 0; k < pass.count; k++ )
+					if( plane.Distance( pass.p[k] ) < -RoomPVS_Epsilon )
+					{
+						separates = False;
+						break;
+					}
+
+				if( !separates )
+					continue;
+
+				if( flip )
+					plane.Flip();
+
+				if( !Clip( target, plane ) )
+					return False;
+			}
+		}
+
+		return True;
+	}
+
+	/// Marks rooms seen from room a through chain of portals ending by pass.
+	/**
+	 *	@param might - rooms all portals of chain may show.
+	 */
+	void Bake( Int a, Room* room, Portal* came_from, const RoomPVSWinding& source, const RoomPVSPlane& source_plane,
+			   const RoomPVSWinding& pass, const DWord* might, vector<Int>& path )
+	{
+		Int depth = (Int)path.size();
+
+		// Too long chain, every room behind it may be seen.
+		if( depth > RoomPVS_Max_Depth )
+		{
+			Flood( GetRow( a ), room, came_from, NULL );
+			return;
+		}
+
+		Bool first = depth == 2;
+		Int r = path[depth - 1];
+		const DWord* seen = GetRow( a );
+		DWord* next_might = masks.begin() + depth * row_size;
+
+		for( Int i = 0; i < (Int)room->portals.size(); i++ )
+		{
+			Portal* portal = room->portals[i];
+			if( portal == came_from )
+				continue;
+
+			Room* next = GetOtherRoom( portal, room );
+			Int n = GetIndex( next );
+			if( n < 0 || find( path.begin(), path.end(), n ) != path.end() )
+				continue;
+
+			// Skip chain if it can not show any room not marked yet.
+			const DWord* portal_might = GetMightSee( r, i );
+			DWord unseen = 0;
+			for( Int k = 0; k < row_size; k++ )
+			{
+				next_might[k] = might[k] & portal_might[k];
+				unseen |= next_might[k] & ~seen[k];
+			}
+
+			if( !unseen )
+				continue;
+
+			RoomPVSWinding target;
+			GetWinding( portal, target );
+
+			if( !Clip( target, source_plane ) )
+				continue;
+
+			if( !first )
+			{
+				if( !ClipToSeparators( source, pass, target, False ) ||
+					!ClipToSeparators( pass, source, target, True ) )
+					continue;
+			}
+
+			Set( a, n );
+
+			path.push_back( n );
+			Bake( a, next, portal, source, source_plane, target, next_might, path );
+			path.pop_back();
+		}
+	}
+
+	/// Marks in row all rooms reachable from room without passing source portal.
+	/**
+	 *	@param plane - if not NULL, only portals with some part in front of it are passed.
+	 */
+	void Flood( DWord* row, Room* room, Portal* source, const RoomPVSPlane* plane )
+	{
+		vector<Room*> stack;
+		vector<Byte> visited( room_count, 0 );
+
+		stack.push_back( room );
+		visited[ GetIndex( room ) ] = 1;
+
+		while( stack.size() )
+		{
+			Room* r = stack[ stack.size() - 1 ];
+			stack.pop_back();
+
+			Int index_r = GetIndex( r );
+			row[ index_r >> 5 ] |= 1UL << ( index_r & 31 );
+
+			for( Int i = 0; i < (Int)r->portals.size(); i++ )
+			{
+				if( (Portal*)r->portals[i] == source )
+					continue;
+
+				Room* next = GetOtherRoom( r->portals[i], r );
+				Int n = GetIndex( next );
+				if( n < 0 || visited[n] )
+					continue;
+
+				if( plane )
+				{
+					RoomPVSWinding w;
+					GetWinding( r->portals[i], w );
+					if( !Clip( w, *plane ) )
+						continue;
+				}
+
+				visited[n] = 1;
+				stack.push_back( next );
+			}
+		}
+	}
+
+	RoomPVS( const RoomPVS& );
+	RoomPVS& operator = ( const RoomPVS& );
+
+	Int room_count;
+
+	/// Number of DWords in bitset of one room.
+	Int row_size;
+
+	/// Hash of room names, checks that data matches rooms.
+	DWord names_hash;
+
+	/// Bitsets of rooms, row_size DWords each.
+	vector<DWord> bits;
+
+	/// Room indices.
+	hash_map<const Room*, Int> index;
+
+	/// Rooms every portal may show, row_size DWords per portal, used by Bake() only.
+	vector<DWord> might_see;
+
+	/// First row in might_see of portals of every room.
+	vector<Int> might_first;
+
+	/// Rooms chains may show, row_size DWords per chain length, used by Bake() only.
+	vector<DWord> masks;
+
+	vector< ObjRef<Room> > empty_rooms;
+};
+
+} //namespace mdragon
+
+#endif // __MD_PVS_H__
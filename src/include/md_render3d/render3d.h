@@ -426,6 +426,102 @@ public:
 	 */
 	Int IsVisible(Vector3fx& pos,Fixed radius);
 
+	/// Returns planes of current camera view frustum.
+	/**
+	 * Planes are in camera space: IsVisible() moves sphere by view and
+	 * world matrices, then sphere is inside when DotProduct( N, pos ) + D
+	 * is greater than -radius for all planes. Sign of D is opposite to
+	 * Plane::HalfSpaceContain(), use GetWorldFrustum() for world space tests.
+	 * @return Returns array of 6 planes.
+	 */
+	inline const Plane* GetFrustum() { return frustum; }
+
+	/// Returns planes of current camera view frustum in world space.
+	/**
+	 * Planes of GetFrustum() moved by inverse of view matrix, inside is
+	 * Plane::HalfSpaceContain(). Used by SceneBVH and LODManager.
+	 * @param planes - array of 6 planes to fill.
+	 */
+	void GetWorldFrustum( Plane* planes )
+	{
+		Matrix4fx v = GetView();
+
+		for( Int i = 0; i < 6; i++ )
+		{
+			const Vector3fx& n = frustum[i].N;
+
+			planes[i].N = Vector3fx( n.x * v._11 + n.y * v._21 + n.z * v._31,
+									 n.x * v._12 + n.y * v._22 + n.z * v._32,
+									 n.x * v._13 + n.y * v._23 + n.z * v._33 );
+			planes[i].D = -( n.x * v._14 + n.y * v._24 + n.z * v._34 + frustum[i].D );
+		}
+	}
+
+	/// Returns triangles queued by Draw() functions since last Flush().
+	/**
+	 * Triangles are projected and clipped, coordinates are in screen pixels.
+	 * Array is valid until next Flush(), triangles must not be changed.
+	 * Used by TileDepthRasterizer.
+	 * @param count - receives number of triangles.
+	 * @return Returns array of pointers to triangles.
+	 */
+	inline TriangleS** GetQueuedTriangles(Int& count) { count = tri_heap_count; return tri_heap_sort; }
+
+	/// Sorts triangles queued since last Flush() in order of Flush().
+	/**
+	 * Flush() quick sorts queue by TriangleS::z from greater to less and
+	 * draws it. Queue sorted by DepthSorter before is left in place by
+	 * Flush() sort, and DepthSorter keeps order of static scenes between
+	 * frames in linear time. Call right before Flush().
+	 * @param sorter - caller owned sorter, one per drawn view.
+	 */
+	inline void SortQueue(DepthSorter& sorter) { sorter.Sort( tri_heap, tri_heap_sort, tri_heap_count, True ); }
+
+	/// Rebuilds depth pyramid from Z-buffer of current viewport.
+	/**
+	 * Call after Flush() of occluders drawn with Z-buffer, for example
+	 * big room geometry, then test other objects by IsOccluded().
+	 * @param hi_z - depth pyramid owned by caller, resized to screen if needed.
+	 */
+	inline void UpdateHiZ(HiZBuffer& hi_z);
+
+	/// Checks if sphere is hidden by geometry drawn before UpdateHiZ().
+	/**
+	 * Tests screen rectangle of sphere against coarse depth pyramid, so
+	 * result is conservative: False for partly hidden spheres and spheres
+	 * crossing near plane.
+	 * @param hi_z - depth pyramid filled by UpdateHiZ().
+	 * @param pos - define sphere position in model coordinate. Will be updated by world matrix. 
+	 * @param radius - define sphere radius.
+	 * @return Returns True if sphere is surely hidden else False.
+	 */
+	inline Bool IsOccluded(HiZBuffer& hi_z,Vector3fx& pos,Fixed radius);
+
+	/// Removes queued triangles hidden by geometry drawn before UpdateHiZ().
+	/**
+	 * Tests every triangle queued since last Flush() by
+	 * HiZBuffer::TestTriangle() and drops hidden ones, so Flush() does not
+	 * sort and rasterize them. Only valid in Z-buffer mode, when hidden
+	 * triangles would fail depth test anyway. Call before SortQueue().
+	 * @param hi_z - depth pyramid filled by UpdateHiZ().
+	 * @return Returns number of removed triangles.
+	 */
+	inline Int CullQueue(HiZBuffer& hi_z);
+
+	/// Calculates screen rectangle covering sphere.
+	/**
+	 * Projection is the same as applied to vertices by Draw(): camera looks
+	 * along -Z, view space vertex is negated and projected by
+	 * TRANSFORM_VERTEXf() and PROJECT_VERTEX(). Rectangle is widened by one
+	 * pixel at each side to cover rounding. See CheckVertexTransform().
+	 * @param pos - define sphere position in model coordinate. Will be updated by world matrix. 
+	 * @param radius - define sphere radius.
+	 * @param x1, y1, x2, y2 - receive screen rectangle (inclusive), may lie out of screen.
+	 * @param dist - receives distance from camera to nearest point of sphere, 16.16 fixed point.
+	 * @return Returns False if sphere is not farther than near plane, else True.
+	 */
+	inline Bool GetScreenRect(Vector3fx& pos,Fixed radius,Int& x1,Int& y1,Int& x2,Int& y2,Int& dist);
+
 	////////////////////////DRAWING MODES//////////////////////////////////
 
 	/// Sets one render mode.
@@ -619,6 +715,9 @@ public:
 	friend class Texture;
 	friend class Font3D;
 	friend class LightMap;
+	friend class SceneBVH;
+	friend class MDGameBenchmark;
+	friend class VertexTransform;
 
 	friend void SortAndBuildLightMap(Render3D *render, vector< ObjRef<Basic3D> >& b3d_list, const Char *file_name_prefix);
 
@@ -629,6 +728,15 @@ public:
 
 	///////////////////////////////////////////////////////////////////////
 
+	/// Morphs vb_0 to vb_1 using caller owned MorphCache.
+	/**
+	 * Key frame VB is returned without morphing if vb_0 is vb_1 or li is
+	 * 0 or 1. Vertex normals are morphed only in Render_Light_Mode.
+	 * @param cache - morphing cache, one per morphed node, see MorphCacheMap.
+	 * @return Returns morphed VB, or NULL if VBs can not be morphed.
+	 */
+	inline ObjRef<VertexBuffer> MorphVB(ObjRef<VertexBuffer> vb_0,ObjRef<VertexBuffer> vb_1,Fixed li,MorphCache& cache);
+
 private:
 
 //////////////////////////////////////////////////////////////////////////
@@ -923,12 +1031,169 @@ inline void Render3D::SetCamera(Camera* camera_)
 	camera = camera_; 
 }
 
+inline void Render3D::UpdateHiZ(HiZBuffer& hi_z)
+{
+	if( hi_z.GetWidth() != SCR_X || hi_z.GetHeight() != SCR_Y )
+		hi_z.Init( SCR_X, SCR_Y );
+
+	hi_z.Update( DISPLAY, SCR_X, RenderX, RenderY, RenderX + RenderWidth - 1, RenderY + RenderHeight - 1 );
+}
+
+inline Bool Render3D::IsOccluded(HiZBuffer& hi_z,Vector3fx& pos,Fixed radius)
+{
+	Int x1, y1, x2, y2, dist;
+
+	if( !hi_z.GetWidth() || !GetScreenRect( pos, radius, x1, y1, x2, y2, dist ) )
+		return False;
+
+	return !hi_z.TestRect( max( x1, -1 ), max( y1, -1 ), min( x2, SCR_X ), min( y2, SCR_Y ), DepthToZBuffer( Fixed( dist, 0 ) ) );
+}
+
+inline Int Render3D::CullQueue(HiZBuffer& hi_z)
+{
+	RENDER3D_PROFILE_SCOPE( Render3D_Stage_Occlusion )
+
+	Int count = 0;
+
+	// Survivors are moved down, so queue stays tri_heap in submission order.
+	for( Int i = 0; i < tri_heap_count; i++ )
+	{
+		if( !hi_z.TestTriangle( tri_heap + i ) )
+			continue;
+
+		if( count != i )
+			tri_heap[count] = tri_heap[i];
+
+		tri_heap_sort[count] = tri_heap + count;
+		count++;
+	}
+
+	Int culled = tri_heap_count - count;
+	tri_heap_count = count;
+
+	return culled;
+}
+
+inline Bool Render3D::GetScreenRect(Vector3fx& pos,Fixed radius,Int& x1,Int& y1,Int& x2,Int& y2,Int& dist)
+{
+	Vector3fx v = TransformVector3( pos, GetViewWorld() );
+
+	// Camera looks along -Z, distances are positive.
+	Long r = radius.value;
+	Long d_near = -(Long)v.z.value - r;
+	Long d_far = -(Long)v.z.value + r;
+
+	if( d_near <= RenderZNear || d_near <= ( 1 << 16 ) || d_far > 0x7FFFFFFF )
+		return False;
+
+	// 1/z as FDiv14x2() in TRANSFORM_VERTEXf().
+	Long iz_near = ( (Long)1 << 30 ) / ( d_near >> 2 );
+	Long iz_far = ( (Long)1 << 30 ) / ( d_far >> 2 );
+
+	// Sides of sphere box negated as by Draw(), each divided by distance giving the widest span.
+	Long ex1 = r - v.x.value, ex2 = -r - v.x.value;
+	Long ey1 = r - v.y.value, ey2 = -r - v.y.value;
+
+	// FMul8x8( FMul8x0( e, 1/z ), perspective ) of TRANSFORM_VERTEXf() in 64 bits.
+	ex1 = ( ( ( ex1 >> 8 ) * ( ex1 > 0 ? iz_near : iz_far ) >> 8 ) >> 8 ) * ( RenderXPerspective >> 8 );
+	ex2 = ( ( ( ex2 >> 8 ) * ( ex2 < 0 ? iz_near : iz_far ) >> 8 ) >> 8 ) * ( RenderXPerspective >> 8 );
+	ey1 = ( ( ( ey1 >> 8 ) * ( ey1 > 0 ? iz_near : iz_far ) >> 8 ) >> 8 ) * ( RenderYPerspective >> 8 );
+	ey2 = ( ( ( ey2 >> 8 ) * ( ey2 < 0 ? iz_near : iz_far ) >> 8 ) >> 8 ) * ( RenderYPerspective >> 8 );
+
+	// PROJECT_VERTEX(): screen X grows with view X, screen Y is mirrored.
+	Long sx1 = ( ( ( 1 << 16 ) - ex1 ) * RenderWidth2 >> 16 ) + RenderX - 1;
+	Long sx2 = ( ( ( 1 << 16 ) - ex2 ) * RenderWidth2 >> 16 ) + RenderX + 1;
+	Long sy1 = ( ( ey2 + ( 1 << 16 ) ) * RenderHeight2 >> 16 ) + RenderY - 1;
+	Long sy2 = ( ( ey1 + ( 1 << 16 ) ) * RenderHeight2 >> 16 ) + RenderY + 1;
+
+	const Long lim = 0x3FFFFFFF;
+	x1 = (Int)max( min( sx1, lim ), -lim );
+	x2 = (Int)max( min( sx2, lim ), -lim );
+	y1 = (Int)max( min( sy1, lim ), -lim );
+	y2 = (Int)max( min( sy2, lim ), -lim );
+	dist = (Int)d_near;
+
+	return True;
+}
+
+inline ObjRef<VertexBuffer> Render3D::MorphVB(ObjRef<VertexBuffer> vb_0,ObjRef<VertexBuffer> vb_1,Fixed li,MorphCache& cache)
+{
+	return cache.Morph( vb_0, vb_1, li, CheckMode( Render_Light_Mode ) );
+}
+
 inline void Render3D::Draw( ObjRef<Sprite3D> sprite_) 
 { 
 	spr_draw_list.push_back(sprite_); 
 }
+
+///////////////////////////////////////////////////////////////////////////
+
+inline void Actor3D::Draw(MorphCacheMap& caches)
+{
+	if( !a3danim )
+		return;
+
+	for( Int i = 0; i < (Int)nodes.size(); i++ )
+	{
+		Basic3D* node = nodes[i];
+
+		if( node->GetClassID() == ClassID_Actor3DNode )
+			( (Actor3DNode*)node )->Draw( caches.Get( node ) );
+		else
+			node->Draw();
+	}
+}
+
+inline void Actor3DNode::Draw(MorphCache& cache)
+{
+	// Same visibility, LOD and light setup as Draw().
+	if( material.transparency <= 250 )
+	{
+		ObjRef<Basic3D> parent_ = GetParent();
+
+		if( parent_ )
+		{
+			Matrix4fx world = parent_->GetResultTransform();
+			render->SetWorld( &world );
+		}
+		else
+			render->SetWorldIdentityMatrix();
+
+		Int clip = render->IsVisible( center, radius );
+
+		ObjRef<VertexBuffer> lod_base, lod_0, lod_1;
+		if( clip > 0 )
+		{
+			lod_base = render->SelectLODVB( vb_base );
+			lod_0 = render->SelectLODVB( vb_0 );
+			lod_1 = render->SelectLODVB( vb_1 );
+		}
+
+		if( lod_base && lod_0 && lod_1 )
+		{
+			render->SetMaterial( &material );
+			render->SetLight( center, radius );
+			render->SetLightMap( ObjRef<LightMap>() );
+
+			Bool light = render->CheckMode( Render_Light_Mode );
+			ObjRef<VertexBuffer> vb = cache.Morph( lod_base, lod_0, lod_1, li, light );
+
+			if( vb )
+			{
+				if( light )
+					render->ComputeLightColor( vb );
+				render->Draw( vb, clip );
+			}
+			else
+				render->Draw( lod_base, lod_0, lod_1, li, clip );
+		}
+	}
+
+	if( link )
+		link->Draw();
+}
 ///////////////////////////////////////////////////////////////////////////
 
 } //namespace mdragon
 
-#endif // __MD_RENDER3D_H__
\ No newline at end of file
+#endif // __MD_RENDER3D_H__
\ No newline at end of file
@@ -66,6 +66,9 @@ public:
 	 */
 	inline const string & GetName() const { return name; }
 
+	/// Returns interned name id.
+	inline NameID GetNameID() const { return NameTable::Instance().Intern( name.c_str() ); }
+
 	/// Returns pointer to Render3D object.
 	/**
 	 * @return Returns pointer to Render3D object.
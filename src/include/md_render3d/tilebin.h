@@ -0,0 +1,457 @@
+/** \file
+ *	Screen tile binning and tiled depth rasterizer. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_TILEBIN_H__
+#define __MD_TILEBIN_H__
+
+namespace mdragon
+{
+
+/// Default tile width and height in pixels.
+#define TileBinner_Tile_Size 32
+
+
+/// Splits viewport into screen tiles and bins triangles to them.
+/**
+ *	Every tile holds indexes of triangles overlapping it in the order they
+ *	were added. Tiles do not overlap, so they can be rasterized in parallel,
+ *	each writing only to its own part of backbuffer and Z-buffer. If
+ *	triangles are added in draw order and rasterizer clips spans to tile
+ *	rectangle without changing interpolation setup, result is the same as
+ *	rasterizing the whole viewport at once. <br>
+ *	Bins are kept in per tile vectors, or in one FrameArena array if
+ *	triangles are binned by Bin() with arena.
+ */
+class TileBinner
+{
+public:
+
+	/// Constructor.
+	TileBinner()
+	{
+		x = y = width = height = 0;
+		tile_size = TileBinner_Tile_Size;
+		tiles_x = tiles_y = 0;
+		arena_first = NULL;
+		arena_index = NULL;
+	}
+
+	/// Splits viewport into tiles. Clears all bins.
+	/**
+	 *	@param x_ - left position of viewport.
+	 *	@param y_ - top position of viewport.
+	 *	@param width_ - viewport width.
+	 *	@param height_ - viewport height.
+	 *	@param tile_size_ - tile width and height in pixels.
+	 */
+	void Init( Int x_, Int y_, Int width_, Int height_, Int tile_size_ = TileBinner_Tile_Size )
+	{
+		x = x_;
+		y = y_;
+		width = width_;
+		height = height_;
+		tile_size = tile_size_ > 0 ? tile_size_ : TileBinner_Tile_Size;
+
+		tiles_x = ( width + tile_size - 1 ) / tile_size;
+		tiles_y = ( height + tile_size - 1 ) / tile_size;
+
+		if( tiles_x < 0 ) tiles_x = 0;
+		if( tiles_y < 0 ) tiles_y = 0;
+
+		bins.resize( tiles_x * tiles_y );
+
+		Clear();
+	}
+
+	/// Clears all bins, keeping allocated memory.
+	void Clear()
+	{
+		for( Int i = 0; i < (Int)bins.size(); i++ )
+			bins[i].clear();
+
+		arena_first = NULL;
+		arena_index = NULL;
+	}
+
+	/// Returns number of tiles.
+	inline Int GetTileCount() { return tiles_x * tiles_y; }
+
+	/// Returns screen rectangle of tile.
+	/**
+	 *	@param tile - tile number.
+	 *	@param x1, y1 - receive top left pixel of tile.
+	 *	@param x2, y2 - receive bottom right pixel of tile (inclusive).
+	 *	Rectangle is empty (x2 < x1) if viewport has no tiles.
+	 */
+	void GetTileRect( Int tile, Int& x1, Int& y1, Int& x2, Int& y2 )
+	{
+		if( !tiles_x )
+		{
+			x1 = y1 = 0;
+			x2 = y2 = -1;
+			return;
+		}
+
+		x1 = x + ( tile % tiles_x ) * tile_size;
+		y1 = y + ( tile / tiles_x ) * tile_size;
+		x2 = min( x1 + tile_size, x + width ) - 1;
+		y2 = min( y1 + tile_size, y + height ) - 1;
+	}
+
+	/// Returns indexes of triangles overlapping tile.
+	/**
+	 *	@param tile - tile number.
+	 *	@param count - receives number of indexes.
+	 *	@return Returns array of indexes.
+	 */
+	inline const Int* GetTile( Int tile, Int& count )
+	{
+		if( arena_first )
+		{
+			count = arena_first[tile+1] - arena_first[tile];
+			return arena_index + arena_first[tile];
+		}
+
+		count = bins[tile].size();
+		return bins[tile].begin();
+	}
+
+	/// Adds triangle to all tiles overlapped by its bounding rectangle.
+	/**
+	 *	@param index - triangle index stored in bins.
+	 *	@param x1, y1, x2, y2 - screen bounding rectangle of triangle (inclusive).
+	 */
+	void Add( Int index, Int x1, Int y1, Int x2, Int y2 )
+	{
+		if( !GetTiles( x1, y1, x2, y2 ) )
+			return;
+
+		for( Int ty = y1; ty <= y2; ty++ )
+			for( Int tx = x1; tx <= x2; tx++ )
+				bins[ ty * tiles_x + tx ].push_back( index );
+	}
+
+	/// Adds sorted triangles to bins.
+	/**
+	 *	Bounding rectangle is taken from screen coordinates of triangle
+	 *	vertices, expanded by one pixel to cover rounding of rasterizer.
+	 *	@param tri - array of pointers to triangles in draw order.
+	 *	@param count - number of triangles.
+	 */
+	void Bin( TriangleS** tri, Int count )
+	{
+		for( Int i = 0; i < count; i++ )
+		{
+			Int x1, y1, x2, y2;
+			GetRect( tri[i], x1, y1, x2, y2 );
+
+			Add( i, x1, y1, x2, y2 );
+		}
+	}
+
+	/// Adds sorted triangles to bins kept in FrameArena.
+	/**
+	 *	Does the same as Bin(), but all bins are one array allocated from
+	 *	arena, counted before filling, so per tile vectors do not grow.
+	 *	Bins are valid until arena is restored below this call or Clear().
+	 *	Falls back to Bin() if arena has no memory.
+	 *	@param tri - array of pointers to triangles in draw order.
+	 *	@param count - number of triangles.
+	 *	@param arena - scratch memory of current frame.
+	 */
+	void Bin( TriangleS** tri, Int count, FrameArena& arena )
+	{
+		Int tiles = GetTileCount();
+		Int* first = arena.Alloc<Int>( tiles + 1 );
+		if( !first )
+		{
+			Bin( tri, count );
+			return;
+		}
+
+		for( Int i = 0; i <= tiles; i++ )
+			first[i] = 0;
+
+		// Count triangles of every tile, then turn counts into start positions.
+		for( Int i = 0; i < count; i++ )
+		{
+			Int x1, y1, x2, y2;
+			GetRect( tri[i], x1, y1, x2, y2 );
+
+			if( GetTiles( x1, y1, x2, y2 ) )
+				for( Int ty = y1; ty <= y2; ty++ )
+					for( Int tx = x1; tx <= x2; tx++ )
+						first[ ty * tiles_x + tx + 1 ]++;
+		}
+
+		for( Int i = 0; i < tiles; i++ )
+			first[i+1] += first[i];
+
+		Int* index = arena.Alloc<Int>( first[tiles] );
+		if( !index )
+		{
+			Bin( tri, count );
+			return;
+		}
+
+		// Fill moves every start to the next tile start, shift back after.
+		for( Int i = 0; i < count; i++ )
+		{
+			Int x1, y1, x2, y2;
+			GetRect( tri[i], x1, y1, x2, y2 );
+
+			if( GetTiles( x1, y1, x2, y2 ) )
+				for( Int ty = y1; ty <= y2; ty++ )
+					for( Int tx = x1; tx <= x2; tx++ )
+						index[ first[ ty * tiles_x + tx ]++ ] = i;
+		}
+
+		for( Int i = tiles; i > 0; i-- )
+			first[i] = first[i-1];
+		first[0] = 0;
+
+		arena_first = first;
+		arena_index = index;
+	}
+
+private:
+
+	/// Returns screen bounding rectangle of triangle, expanded by one pixel.
+	static inline void GetRect( const TriangleS* t, Int& x1, Int& y1, Int& x2, Int& y2 )
+	{
+		x1 = min( min( t->a.sx, t->b.sx ), t->c.sx ) - 1;
+		y1 = min( min( t->a.sy, t->b.sy ), t->c.sy ) - 1;
+		x2 = max( max( t->a.sx, t->b.sx ), t->c.sx ) + 1;
+		y2 = max( max( t->a.sy, t->b.sy ), t->c.sy ) + 1;
+	}
+
+	/// Converts screen rectangle to range of tiles, returns False if it is outside viewport.
+	inline Bool GetTiles( Int& x1, Int& y1, Int& x2, Int& y2 )
+	{
+		if( x2 < x || y2 < y || x1 >= x + width || y1 >= y + height )
+			return False;
+
+		x1 = x1 > x ? ( x1 - x ) / tile_size : 0;
+		y1 = y1 > y ? ( y1 - y ) / tile_size : 0;
+		x2 = min( ( x2 - x ) / tile_size, tiles_x - 1 );
+		y2 = min( ( y2 - y ) / tile_size, tiles_y - 1 );
+
+		return True;
+	}
+
+	Int x, y, width, height;
+	Int tile_size;
+	Int tiles_x, tiles_y;
+
+	vector< vector<Int> > bins;
+
+	Int* arena_first;
+	Int* arena_index;
+};
+
+
+/// Rasterizes depth of projected triangles by screen tiles in parallel.
+/**
+ *	Triangles are binned by TileBinner and every tile is rasterized by one
+ *	WorkerPool part, writing only its own rectangle of the depth buffer.
+ *	Only depth is written, in Z-buffer units (see DepthToZBuffer()), nearer
+ *	depth wins. Colors, textures and blending stay in Render3D::Flush(). <br>
+ *	Coverage and depth are conservative for occlusion tests: only pixels
+ *	with centers strictly inside triangle are written, and depth is never
+ *	nearer than the farthest vertex of triangle allows at that pixel.
+ *	Triangles with alpha or logic op flags are skipped, textures with
+ *	transparent texels are rasterized as opaque. <br>
+ *	Usual source is Render3D::GetQueuedTriangles() before Render3D::Flush():
+ *	\code
+ *	Int count;
+ *	TriangleS** tri = render->GetQueuedTriangles( count );
+ *	depth_raster.Clear();
+ *	depth_raster.Rasterize( pool, tri, count, &arena );
+ *	render->Flush();
+ *	\endcode
+ */
+class TileDepthRasterizer : public WorkerJob
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( TileDepthRasterizer, MemoryTag_Render3D )
+
+	/// Constructor.
+	TileDepthRasterizer() : width( 0 ), height( 0 ), tri( NULL ) {}
+
+	/// Allocates depth buffer and tiles.
+	/**
+	 *	@param width_ - depth buffer width, usually screen width.
+	 *	@param height_ - depth buffer height, usually screen height.
+	 *	@param tile_size - tile width and height in pixels.
+	 */
+	void Init( Int width_, Int height_, Int tile_size = TileBinner_Tile_Size )
+	{
+		width = max( width_, 0 );
+		height = max( height_, 0 );
+
+		binner.Init( 0, 0, width, height, tile_size );
+
+		depth.clear();
+		depth.resize( width * height, 0 );
+	}
+
+	/// Sets whole depth buffer to given depth, 0 is the farthest.
+	void Clear( Word depth_ = 0 )
+	{
+		for( Int i = 0; i < (Int)depth.size(); i++ )
+			depth[i] = depth_;
+	}
+
+	/// Rasterizes triangles to depth buffer.
+	/**
+	 *	Waits until all tiles are done.
+	 *	@param pool - threads rasterizing tiles.
+	 *	@param tri_ - array of pointers to triangles with screen coordinates.
+	 *	@param count - number of triangles.
+	 *	@param arena - scratch memory for bins, released before return.
+	 *	NULL to keep bins in vectors.
+	 */
+	void Rasterize( WorkerPool& pool, TriangleS** tri_, Int count, FrameArena* arena = NULL )
+	{
+		binner.Clear();
+
+		if( !arena )
+		{
+			binner.Bin( tri_, count );
+			Run( pool, tri_ );
+			return;
+		}
+
+		FrameArenaScope scope( *arena );
+
+		binner.Bin( tri_, count, *arena );
+		Run( pool, tri_ );
+		binner.Clear();
+	}
+
+	/// Rasterizes triangles binned to one tile. Called by WorkerPool.
+	void Execute( Int index, Int thread )
+	{
+		Int x1, y1, x2, y2;
+		binner.GetTileRect( index, x1, y1, x2, y2 );
+
+		Int count;
+		const Int* bin = binner.GetTile( index, count );
+
+		for( Int i = 0; i < count; i++ )
+			RasterizeTriangle( tri[ bin[i] ], x1, y1, x2, y2 );
+	}
+
+	/// Returns depth buffer, width values per line.
+	inline const Word* GetDepth() { return depth.begin(); }
+
+	/// Returns depth buffer width.
+	inline Int GetWidth() { return width; }
+
+	/// Returns depth buffer height.
+	inline Int GetHeight() { return height; }
+
+private:
+
+	/// Rasterizes binned tiles.
+	void Run( WorkerPool& pool, TriangleS** tri_ )
+	{
+		tri = tri_;
+		pool.Run( this, binner.GetTileCount() );
+		tri = NULL;
+	}
+
+	/// Rasterizes part of triangle inside rectangle (inclusive).
+	void RasterizeTriangle( const TriangleS* t, Int x1, Int y1, Int x2, Int y2 )
+	{
+		if( t->alpha || ( t->flags & ( DRAW_AND | DRAW_OR | DRAW_MASK ) ) )
+			return;
+
+		const VertexS* a = &t->a;
+		const VertexS* b = &t->b;
+		const VertexS* c = &t->c;
+
+		Long area = (Long)( b->sx - a->sx ) * ( c->sy - a->sy ) - (Long)( b->sy - a->sy ) * ( c->sx - a->sx );
+		if( area == 0 )
+			return;
+
+		// Make edge functions positive inside.
+		if( area < 0 )
+		{
+			const VertexS* s = b; b = c; c = s;
+			area = -area;
+		}
+
+		x1 = max( x1, (Int)min( a->sx, min( b->sx, c->sx ) ) );
+		y1 = max( y1, (Int)min( a->sy, min( b->sy, c->sy ) ) );
+		x2 = min( x2, (Int)max( a->sx, max( b->sx, c->sx ) ) );
+		y2 = min( y2, (Int)max( a->sy, max( b->sy, c->sy ) ) );
+
+		if( x1 > x2 || y1 > y2 )
+			return;
+
+		// Edge function of edge p-q at pixel (x,y) and its steps.
+		Long e0_dx = b->sy - c->sy, e0_dy = c->sx - b->sx;
+		Long e1_dx = c->sy - a->sy, e1_dy = a->sx - c->sx;
+		Long e2_dx = a->sy - b->sy, e2_dy = b->sx - a->sx;
+
+		Long e0 = ( x1 - b->sx ) * e0_dx + ( y1 - b->sy ) * e0_dy;
+		Long e1 = ( x1 - c->sx ) * e1_dx + ( y1 - c->sy ) * e1_dy;
+		Long e2 = ( x1 - a->sx ) * e2_dx + ( y1 - a->sy ) * e2_dy;
+
+		// Depth plane in 16.16, depth = ( e0 * za + e1 * zb + e2 * zc ) / area.
+		// It is evaluated from screen origin, so pixel depth does not depend on tile size.
+		Long z_dx = ( ( e0_dx * a->z + e1_dx * b->z + e2_dx * c->z ) << 16 ) / area;
+		Long z_dy = ( ( e0_dy * a->z + e1_dy * b->z + e2_dy * c->z ) << 16 ) / area;
+		Long z_0 = ( ( ( -b->sx * e0_dx - b->sy * e0_dy ) * a->z + ( -c->sx * e1_dx - c->sy * e1_dy ) * b->z +
+				( -a->sx * e2_dx - a->sy * e2_dy ) * c->z ) << 16 ) / area;
+		Long z = z_0 + x1 * z_dx + y1 * z_dy;
+
+		// Rounding error of plane is below 2 depth units for 16 bit screen coordinates,
+		// bias keeps depth from getting nearer.
+		Long z_min = (Long)min( a->z, min( b->z, c->z ) ) << 16;
+		Long z_max = (Long)max( a->z, max( b->z, c->z ) ) << 16;
+		Long z_bias = 2 << 16;
+
+		Word* line = depth.begin() + y1 * width;
+
+		for( Int y = y1; y <= y2; y++, line += width )
+		{
+			Long f0 = e0, f1 = e1, f2 = e2, fz = z;
+
+			for( Int x = x1; x <= x2; x++ )
+			{
+				if( f0 > 0 && f1 > 0 && f2 > 0 )
+				{
+					Long d = fz - z_bias;
+					if( d < z_min ) d = z_min;
+					if( d > z_max ) d = z_max;
+
+					Word w = (Word)( d >> 16 );
+					if( w > line[x] )
+						line[x] = w;
+				}
+
+				f0 += e0_dx; f1 += e1_dx; f2 += e2_dx; fz += z_dx;
+			}
+
+			e0 += e0_dy; e1 += e1_dy; e2 += e2_dy; z += z_dy;
+		}
+	}
+
+	Int width, height;
+
+	TileBinner binner;
+	vector<Word> depth;
+
+	TriangleS** tri;
+};
+
+} //namespace mdragon
+
+#endif // __MD_TILEBIN_H__
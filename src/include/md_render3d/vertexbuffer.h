@@ -65,6 +65,44 @@ class Light;
 class CollisionManager;
 
 
+/// Whole VB channel.
+/**
+ *	Element c of vertex i is data[ i * stride + c * pitch ]. VertexBuffer
+ *	channels have pitch 1, VertexBufferSoA channels have stride 1 and
+ *	Component() returns contiguous array of one component.
+ */
+template<class T>
+class VertexChannel
+{
+public:
+
+	/// Constructor.
+	VertexChannel( T* data_, Int count_, Int stride_, Int pitch_ )
+		: data( data_ ), count( count_ ), stride( stride_ ), pitch( pitch_ ) {}
+
+	/// Returns pointer to component c of the first vertex.
+	inline T* Component( Int c ) { return data + c * pitch; }
+
+	/// Provides access to component c of vertex i.
+	inline T& operator () ( Int i, Int c ) { return data[ i * stride + c * pitch ]; }
+
+	/// Checks if components are stored in contiguous arrays.
+	inline Bool IsPlanar() { return stride == 1; }
+
+	/// Channel data.
+	T* data;
+
+	/// Number of vertices (triangles for triangle normals).
+	Int count;
+
+	/// Distance between vertices in elements.
+	Int stride;
+
+	/// Distance between components of vertex in elements.
+	Int pitch;
+};
+
+
 /// VertexBuffer (farther VB) represents geometry container.
 /**
  * VB may contain various geometry data: vertex coordinates, vertex normals, 
@@ -131,6 +169,9 @@ public:
 	 *	@return Return name for this object.
 	 */
 	inline const string & GetName() { return name; }
+
+	/// Returns interned name id.
+	inline NameID GetNameID() { return NameTable::Instance().Intern( name.c_str() ); }
 	
 
 	/////////////////////INITIALIZATION/////////////////////
@@ -441,6 +482,41 @@ public:
 	 *  @param i - index of triangle.
 	 */
 	inline Word& IndexC(Word i) { return index[i*3+2]; }
+
+	/////////////////////BULK DATA ACCESS///////////////////
+
+	/// Returns vertex X, Y, Z channel.
+	inline VertexChannel<Fixed> GetVxyz() { return VertexChannel<Fixed>( v_xyz, vertex_count, v_xyz_stride, 1 ); }
+
+	/// Returns vertex normal X, Y, Z channel.
+	inline VertexChannel<Fixed> GetNxyz() { return VertexChannel<Fixed>( n_xyz, vertex_count, n_xyz_stride, 1 ); }
+
+	/// Returns triangle normal X, Y, Z channel.
+	inline VertexChannel<Fixed> GetTriNxyz() { return VertexChannel<Fixed>( tri_n_xyz, index_count / 3, tri_n_xyz_stride, 1 ); }
+
+	/// Returns U, V channel 0.
+	inline VertexChannel<Fixed> GetUV0() { return VertexChannel<Fixed>( uv_0, vertex_count, uv_0_stride, 1 ); }
+
+	/// Returns U, V channel 1.
+	inline VertexChannel<Fixed> GetUV1() { return VertexChannel<Fixed>( uv_1, vertex_count, uv_1_stride, 1 ); }
+
+	/// Returns vertex intensity channel.
+	inline VertexChannel<Int> GetIntensity() { return VertexChannel<Int>( intensity, vertex_count, intensity_stride, 1 ); }
+
+	/// Returns packed vertex X, Y, Z channel.
+	inline VertexChannel<Short> GetVxyzPacked() { return VertexChannel<Short>( (Short*)v_xyz, vertex_count, v_xyz_stride, 1 ); }
+
+	/// Returns packed vertex normal X, Y, Z channel.
+	inline VertexChannel<Short> GetNxyzPacked() { return VertexChannel<Short>( (Short*)n_xyz, vertex_count, n_xyz_stride, 1 ); }
+
+	/// Returns packed triangle normal X, Y, Z channel.
+	inline VertexChannel<Short> GetTriNxyzPacked() { return VertexChannel<Short>( (Short*)tri_n_xyz, index_count / 3, tri_n_xyz_stride, 1 ); }
+
+	/// Returns packed U, V channel 0.
+	inline VertexChannel<Short> GetUV0Packed() { return VertexChannel<Short>( (Short*)uv_0, vertex_count, uv_0_stride, 1 ); }
+
+	/// Returns packed U, V channel 1.
+	inline VertexChannel<Short> GetUV1Packed() { return VertexChannel<Short>( (Short*)uv_1, vertex_count, uv_1_stride, 1 ); }
 	
 	///////////////////////LOD MANAGEMENT///////////////////
 
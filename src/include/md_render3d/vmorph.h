@@ -0,0 +1,363 @@
+/** \file
+ *	Batch morphing of vertex buffers. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_VMORPH_H__
+#define __MD_VMORPH_H__
+
+namespace mdragon
+{
+
+#ifndef Fixed
+
+/// Morphs S::Width elements starting at i: out = a + FixedMul( b - a, li ).
+template<class S>
+inline void MorphLanes( const Int* a, const Int* b, Int* out, typename S::V li, Int i )
+{
+	typename S::V va = S::Load( a + i );
+	S::Store( out + i, S::Add( va, S::MulFixed( S::Sub( S::Load( b + i ), va ), li ) ) );
+}
+
+
+/// Morphs array of 16.16 fixed point values.
+/**
+ *	Result is the same as Fixed expression a + ( b - a ) * li for every element.
+ *	@param a - start values.
+ *	@param b - end values.
+ *	@param out - receives result, may be the same as a or b.
+ *	@param n - number of elements.
+ *	@param li - interpolation value from 0 to 1 in 16.16 fixed point.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ */
+inline void MorphArray( const Int* a, const Int* b, Int* out, Int n, Int li, Bool simd = True )
+{
+	Int i = 0;
+
+#ifdef MD_SIMD
+	if( simd )
+	{
+		SimdNative::V vli = SimdNative::Set( li );
+		for( ; i + SimdNative::Width <= n; i += SimdNative::Width )
+			MorphLanes<SimdNative>( a, b, out, vli, i );
+	}
+#endif
+
+	for( ; i < n; i++ )
+		MorphLanes<SimdScalar>( a, b, out, li, i );
+}
+
+
+/// Morphs VertexBuffer channel.
+/**
+ *	Channels with the same layout are morphed by MorphArray() as one
+ *	array (VertexBuffer) or one array per component (VertexBufferSoA),
+ *	other channels are morphed element by element.
+ *	@param out - receiving channel.
+ *	@param c0 - start channel.
+ *	@param c1 - end channel.
+ *	@param components - number of components per vertex.
+ *	@param li - interpolation value from 0 to 1.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ */
+inline void MorphChannel( VertexChannel<Fixed> out, VertexChannel<Fixed> c0, VertexChannel<Fixed> c1,
+		Int components, Fixed li, Bool simd = True )
+{
+	Int n = min( out.count, min( c0.count, c1.count ) );
+
+	if( out.stride == c0.stride && out.stride == c1.stride && out.pitch == c0.pitch && out.pitch == c1.pitch )
+	{
+		if( out.stride == components && out.pitch == 1 )
+		{
+			MorphArray( reinterpret_cast<const Int*>( c0.data ), reinterpret_cast<const Int*>( c1.data ),
+					reinterpret_cast<Int*>( out.data ), n * components, li.value, simd );
+			return;
+		}
+
+		if( out.stride == 1 )
+		{
+			for( Int c = 0; c < components; c++ )
+				MorphArray( reinterpret_cast<const Int*>( c0.Component( c ) ), reinterpret_cast<const Int*>( c1.Component( c ) ),
+						reinterpret_cast<Int*>( out.Component( c ) ), n, li.value, simd );
+			return;
+		}
+	}
+
+	for( Int i = 0; i < n; i++ )
+		for( Int c = 0; c < components; c++ )
+			out( i, c ) = c0( i, c ) + ( c1( i, c ) - c0( i, c ) ) * li;
+}
+
+
+/// Morphs vertices and optionally vertex normals of two VBs into third VB.
+/**
+ *	Only Vxyz and Nxyz channels are written, all other data of out is
+ *	left unchanged. Packed VBs are not supported.
+ *	@param out - receiving VB, must have Vxyz (and Nxyz for normals) format
+ *	and at least vb_0 vertex count capacity.
+ *	@param vb_0 - start VB.
+ *	@param vb_1 - end VB.
+ *	@param li - interpolation value from 0 to 1.
+ *	@param normals - True to morph vertex normals too, for example if lighting is on.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ *	@return True if morphed successfully else False.
+ */
+inline Bool MorphVertexBuffer( VertexBuffer& out, VertexBuffer& vb_0, VertexBuffer& vb_1, Fixed li, Bool normals, Bool simd = True )
+{
+	if( ( vb_0.GetFormat() | vb_1.GetFormat() | out.GetFormat() ) & VertexBuffer_Format_Packed )
+		return False;
+
+	if( !vb_0.CheckFormat( VertexBuffer_Format_Vxyz ) || !vb_1.CheckFormat( VertexBuffer_Format_Vxyz ) || !out.CheckFormat( VertexBuffer_Format_Vxyz ) )
+		return False;
+
+	if( vb_1.GetVertexCount() != vb_0.GetVertexCount() || out.GetMaxVertexCount() < vb_0.GetVertexCount() )
+		return False;
+
+	normals = normals && vb_0.CheckFormat( VertexBuffer_Format_Nxyz ) && vb_1.CheckFormat( VertexBuffer_Format_Nxyz ) && out.CheckFormat( VertexBuffer_Format_Nxyz );
+
+	RENDER3D_PROFILE_SCOPE( Render3D_Stage_Morph )
+	RENDER3D_PROFILE_COUNT( vertices_morphed, vb_0.GetVertexCount() )
+
+	out.SetVertexCount( vb_0.GetVertexCount() );
+
+	vb_0.Lock( VertexBuffer_LockType_Read );
+	vb_1.Lock( VertexBuffer_LockType_Read );
+	out.Lock( VertexBuffer_LockType_Write );
+
+	MorphChannel( out.GetVxyz(), vb_0.GetVxyz(), vb_1.GetVxyz(), 3, li, simd );
+
+	if( normals )
+		MorphChannel( out.GetNxyz(), vb_0.GetNxyz(), vb_1.GetNxyz(), 3, li, simd );
+
+	out.UnLock();
+	vb_1.UnLock();
+	vb_0.UnLock();
+
+	return True;
+}
+
+
+/// Morphs vertices and optionally vertex normals of two SoA VBs into third SoA VB.
+/**
+ *	Result is the same as of MorphVertexBuffer() for VertexBuffer.
+ *	@param out - receiving VB, must have at least vb_0 vertex count capacity.
+ *	@param vb_0 - start VB.
+ *	@param vb_1 - end VB.
+ *	@param li - interpolation value from 0 to 1.
+ *	@param normals - True to morph vertex normals too, for example if lighting is on.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ *	@return True if morphed successfully else False.
+ */
+inline Bool MorphVertexBuffer( VertexBufferSoA& out, VertexBufferSoA& vb_0, VertexBufferSoA& vb_1, Fixed li, Bool normals, Bool simd = True )
+{
+	if( !vb_0.CheckFormat( VertexBuffer_Format_Vxyz ) || !vb_1.CheckFormat( VertexBuffer_Format_Vxyz ) || !out.CheckFormat( VertexBuffer_Format_Vxyz ) )
+		return False;
+
+	if( vb_1.GetVertexCount() != vb_0.GetVertexCount() || out.GetMaxVertexCount() < vb_0.GetVertexCount() )
+		return False;
+
+	normals = normals && vb_0.CheckFormat( VertexBuffer_Format_Nxyz ) && vb_1.CheckFormat( VertexBuffer_Format_Nxyz ) && out.CheckFormat( VertexBuffer_Format_Nxyz );
+
+	RENDER3D_PROFILE_SCOPE( Render3D_Stage_Morph )
+	RENDER3D_PROFILE_COUNT( vertices_morphed, vb_0.GetVertexCount() )
+
+	out.SetVertexCount( vb_0.GetVertexCount() );
+
+	MorphChannel( out.GetVxyz(), vb_0.GetVxyz(), vb_1.GetVxyz(), 3, li, simd );
+
+	if( normals )
+		MorphChannel( out.GetNxyz(), vb_0.GetNxyz(), vb_1.GetNxyz(), 3, li, simd );
+
+	return True;
+}
+
+
+/// Reusable morphing result.
+/**
+ *	Keeps VB with the last morphing result and parameters it was made
+ *	with, so paused or slow animations do not morph again. Key frame VBs
+ *	must not be changed while they are referenced by cache.
+ */
+class MorphCache
+{
+public:
+
+	/// Constructor.
+	MorphCache() : li( 0, 0 ), normals( False ) {}
+
+	/// Morphs vb_0 to vb_1 or returns result of previous call.
+	/**
+	 *	No morphing is done if vb_0 and vb_1 are the same VB or li is 0 or
+	 *	1, the key frame VB is returned instead. Result is the same as of
+	 *	MorphVertexBuffer() in all cases.
+	 *	@param vb_0_ - start VB.
+	 *	@param vb_1_ - end VB.
+	 *	@param li_ - interpolation value from 0 to 1.
+	 *	@param normals_ - True to morph vertex normals too.
+	 *	@return Returns morphed VB, or NULL if VBs can not be morphed.
+	 */
+	ObjRef<VertexBuffer> Morph( ObjRef<VertexBuffer> vb_0_, ObjRef<VertexBuffer> vb_1_, Fixed li_, Bool normals_ )
+	{
+		if( vb_0_ == vb_1_ || li_ <= F_ZERO )
+			return vb_0_;
+
+		if( li_ >= F_ONE )
+			return vb_1_;
+
+		if( vb_0 && !base && vb_0 == vb_0_ && vb_1 == vb_1_ && li == li_ && ( normals || !normals_ ) )
+			return vb;
+
+		Int format = vb_0_->GetFormat() & ( VertexBuffer_Format_Vxyz | VertexBuffer_Format_Nxyz );
+
+		if( !vb || base || vb->GetFormat() != format || vb->GetMaxVertexCount() < vb_0_->GetVertexCount() )
+		{
+			base = ObjRef<VertexBuffer>();
+			vb = VertexBuffer::New();
+			if( !vb->Init( format, vb_0_->GetVertexCount(), 0 ) )
+			{
+				Clear();
+				return ObjRef<VertexBuffer>();
+			}
+		}
+
+		if( !MorphVertexBuffer( *vb, *vb_0_, *vb_1_, li_, normals_ ) )
+		{
+			Clear();
+			return ObjRef<VertexBuffer>();
+		}
+
+		vb_0 = vb_0_;
+		vb_1 = vb_1_;
+		li = li_;
+		normals = normals_;
+
+		return vb;
+	}
+
+	/// Morphs vb_0 to vb_1 into VB that can be drawn without vb_base.
+	/**
+	 *	Result VB has vertices and vertex normals of morphing and all other
+	 *	data of vb_base, so Render3D::Draw(vb,clip) draws it without
+	 *	morphing again. vb_base data is copied only when result VB is made
+	 *	for new vb_base. Key frames are copied into result VB too.
+	 *	@param vb_base_ - base VB with indices, texture coordinates and
+	 *	other data not present in vb_0 and vb_1.
+	 *	@param vb_0_ - start VB.
+	 *	@param vb_1_ - end VB.
+	 *	@param li_ - interpolation value from 0 to 1.
+	 *	@param normals_ - True to morph vertex normals too.
+	 *	@return Returns morphed VB, or NULL if VBs can not be morphed, for
+	 *	example packed VBs.
+	 */
+	ObjRef<VertexBuffer> Morph( ObjRef<VertexBuffer> vb_base_, ObjRef<VertexBuffer> vb_0_, ObjRef<VertexBuffer> vb_1_, Fixed li_, Bool normals_ )
+	{
+		if( !vb_base_ || vb_base_->CheckFormat( VertexBuffer_Format_Packed ) )
+			return ObjRef<VertexBuffer>();
+
+		if( li_ < F_ZERO )
+			li_ = F_ZERO;
+		else if( li_ > F_ONE )
+			li_ = F_ONE;
+
+		if( vb_0_ == vb_1_ )
+			li_ = F_ZERO;
+
+		if( vb && base == vb_base_ && vb_0 == vb_0_ && vb_1 == vb_1_ && li == li_ && ( normals || !normals_ ) )
+			return vb;
+
+		if( !vb || base != vb_base_ || vb->GetMaxVertexCount() < vb_0_->GetVertexCount() )
+		{
+			Int base_format = vb_base_->GetFormat() & ~( VertexBuffer_Format_Vxyz | VertexBuffer_Format_Nxyz | VertexBuffer_Format_LOD );
+			Int format = base_format | ( vb_0_->GetFormat() & ( VertexBuffer_Format_Vxyz | VertexBuffer_Format_Nxyz ) );
+
+			vb = VertexBuffer::New();
+			if( !vb->Init( format, vb_0_->GetVertexCount(), vb_base_->GetIndexCount() ) || !vb->Copy( *vb_base_, base_format ) )
+			{
+				Clear();
+				return ObjRef<VertexBuffer>();
+			}
+			base = vb_base_;
+		}
+
+		if( !MorphVertexBuffer( *vb, *vb_0_, *vb_1_, li_, normals_ ) )
+		{
+			Clear();
+			return ObjRef<VertexBuffer>();
+		}
+
+		vb_0 = vb_0_;
+		vb_1 = vb_1_;
+		li = li_;
+		normals = normals_;
+
+		return vb;
+	}
+
+	/// Forgets last result and frees its VB.
+	void Clear()
+	{
+		base = ObjRef<VertexBuffer>();
+		vb_0 = ObjRef<VertexBuffer>();
+		vb_1 = ObjRef<VertexBuffer>();
+		vb = ObjRef<VertexBuffer>();
+	}
+
+private:
+
+	ObjRef<VertexBuffer> base;
+	ObjRef<VertexBuffer> vb_0;
+	ObjRef<VertexBuffer> vb_1;
+	Fixed li;
+	Bool normals;
+
+	ObjRef<VertexBuffer> vb;
+};
+
+
+/// Morphing caches of many nodes.
+/**
+ *	Caller owned set of MorphCache, one per morphed node, keyed by node
+ *	pointer. Nodes must be forgotten when they are destroyed.
+ */
+class MorphCacheMap
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( MorphCacheMap, MemoryTag_Render3D )
+
+	/// Returns cache of node, creates empty cache for new node.
+	MorphCache& Get( const void* node )
+	{
+		return caches[ node ];
+	}
+
+	/// Frees cache of node.
+	void Forget( const void* node )
+	{
+		caches.erase( node );
+	}
+
+	/// Frees all caches.
+	void Clear()
+	{
+		caches.clear();
+	}
+
+	/// Returns number of cached nodes.
+	Int Size() const
+	{
+		return caches.size();
+	}
+
+private:
+
+	hash_map<const void*, MorphCache> caches;
+};
+
+#endif // Fixed
+
+} //namespace mdragon
+
+#endif // __MD_VMORPH_H__
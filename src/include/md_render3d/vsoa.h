@@ -0,0 +1,202 @@
+/** \file
+ *	Vertex coordinates and normals stored as structure of arrays. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_VSOA_H__
+#define __MD_VSOA_H__
+
+namespace mdragon
+{
+
+#ifndef Fixed
+
+/// Alignment of VertexBufferSoA component arrays in elements. 8 Fixed elements is 32 bytes.
+#define VertexBufferSoA_Align 8
+
+
+/// Vertex coordinates and normals stored as structure of arrays.
+/**
+ *	All X values of channel are followed by all Y values and so on. Every
+ *	component array starts at VertexBufferSoA_Align elements boundary in
+ *	memory and is padded to VertexBufferSoA_Align elements, so batch
+ *	kernels can read whole SIMD registers past vertex count. <br>
+ *	VertexBufferSoA is built and used by header code only: Load() copies
+ *	vertices from VertexBuffer, Store() copies results back to VertexBuffer
+ *	for drawing.
+ */
+class VertexBufferSoA
+{
+public:
+
+	/// Constructor.
+	VertexBufferSoA() : format( 0 ), vertex_count( 0 ), max_vertex_count( 0 ), pitch( 0 ) {}
+
+	/// Allocates component arrays.
+	/**
+	 *	Arrays are zero filled.
+	 *	@param format_ - VertexBuffer_Format_Vxyz and optionally VertexBuffer_Format_Nxyz,
+	 *	other flags are ignored.
+	 *	@param vertex_count_ - necessary vertex count.
+	 *	@return True if initialized successfully else False.
+	 */
+	Bool Init( Int format_, Int vertex_count_ )
+	{
+		format = format_ & ( VertexBuffer_Format_Vxyz | VertexBuffer_Format_Nxyz );
+		if( !( format & VertexBuffer_Format_Vxyz ) || vertex_count_ < 0 )
+		{
+			format = 0;
+			return False;
+		}
+
+		pitch = Pitch( vertex_count_ );
+		vertex_count = max_vertex_count = vertex_count_;
+
+		// Extra elements let Aligned() skip to the alignment boundary.
+		v_xyz.clear();
+		v_xyz.resize( 3 * pitch + VertexBufferSoA_Align - 1, F_ZERO );
+
+		n_xyz.clear();
+		if( format & VertexBuffer_Format_Nxyz )
+			n_xyz.resize( 3 * pitch + VertexBufferSoA_Align - 1, F_ZERO );
+
+		return True;
+	}
+
+	/// Return format, see Init().
+	inline Int GetFormat() { return format; }
+
+	/// Checks if format flag is set.
+	inline Bool CheckFormat( Int format_ ) { return ( format & format_ ) != 0; }
+
+	/// Return current vertex count.
+	inline Int GetVertexCount() { return vertex_count; }
+
+	/// Return max vertex count.
+	inline Int GetMaxVertexCount() { return max_vertex_count; }
+
+	/// Sets current vertex count, clamped to max vertex count.
+	inline void SetVertexCount( Int count ) { vertex_count = min( count, max_vertex_count ); }
+
+	/// Returns vertex X, Y, Z channel.
+	inline VertexChannel<Fixed> GetVxyz() { return VertexChannel<Fixed>( Aligned( v_xyz ), vertex_count, 1, pitch ); }
+
+	/// Returns vertex normal X, Y, Z channel.
+	inline VertexChannel<Fixed> GetNxyz() { return VertexChannel<Fixed>( Aligned( n_xyz ), vertex_count, 1, pitch ); }
+
+	/// Copies vertices and vertex normals from VB.
+	/**
+	 *	Arrays are reallocated if VB format or vertex count does not fit.
+	 *	@param vb - source VB, packed VBs are not supported.
+	 *	@return True if copied successfully else False.
+	 */
+	Bool Load( VertexBuffer& vb )
+	{
+		if( vb.CheckFormat( VertexBuffer_Format_Packed ) || !vb.CheckFormat( VertexBuffer_Format_Vxyz ) )
+			return False;
+
+		Int format_ = vb.GetFormat() & ( VertexBuffer_Format_Vxyz | VertexBuffer_Format_Nxyz );
+
+		if( format_ != format || max_vertex_count < vb.GetVertexCount() )
+		{
+			if( !Init( format_, vb.GetVertexCount() ) )
+				return False;
+		}
+
+		SetVertexCount( vb.GetVertexCount() );
+
+		vb.Lock( VertexBuffer_LockType_Read );
+
+		CopyChannel( GetVxyz(), vb.GetVxyz() );
+
+		if( format & VertexBuffer_Format_Nxyz )
+			CopyChannel( GetNxyz(), vb.GetNxyz() );
+
+		vb.UnLock();
+
+		return True;
+	}
+
+	/// Copies vertices and vertex normals to VB.
+	/**
+	 *	Vertex normals are copied if both have them, all other data of vb
+	 *	is left unchanged.
+	 *	@param vb - receiving VB, must have Vxyz format and at least vertex
+	 *	count capacity, packed VBs are not supported.
+	 *	@return True if copied successfully else False.
+	 */
+	Bool Store( VertexBuffer& vb )
+	{
+		if( vb.CheckFormat( VertexBuffer_Format_Packed ) || !vb.CheckFormat( VertexBuffer_Format_Vxyz ) )
+			return False;
+
+		if( vb.GetMaxVertexCount() < vertex_count )
+			return False;
+
+		vb.SetVertexCount( (Word)vertex_count );
+
+		vb.Lock( VertexBuffer_LockType_Write );
+
+		CopyChannel( vb.GetVxyz(), GetVxyz() );
+
+		if( ( format & VertexBuffer_Format_Nxyz ) && vb.CheckFormat( VertexBuffer_Format_Nxyz ) )
+			CopyChannel( vb.GetNxyz(), GetNxyz() );
+
+		vb.UnLock();
+
+		return True;
+	}
+
+	/// Returns component array length for given number of vertices.
+	static inline Int Pitch( Int count ) { return ( count + VertexBufferSoA_Align - 1 ) & ~( VertexBufferSoA_Align - 1 ); }
+
+private:
+
+	/// Returns first element of array at VertexBufferSoA_Align elements boundary.
+	static inline Fixed* Aligned( vector<Fixed>& a )
+	{
+		const size_t bytes = VertexBufferSoA_Align * sizeof(Fixed);
+		size_t skip = ( bytes - ( (size_t)a.begin() & ( bytes - 1 ) ) ) & ( bytes - 1 );
+
+		return a.begin() + skip / sizeof(Fixed);
+	}
+
+	/// Copies X, Y, Z channel between layouts.
+	static void CopyChannel( VertexChannel<Fixed> out, VertexChannel<Fixed> in )
+	{
+		Int n = min( out.count, in.count );
+
+		for( Int i = 0; i < n; i++ )
+		{
+			out( i, 0 ) = in( i, 0 );
+			out( i, 1 ) = in( i, 1 );
+			out( i, 2 ) = in( i, 2 );
+		}
+	}
+
+	/// Format, see Init().
+	Int format;
+
+	/// Current vertex count.
+	Int vertex_count;
+
+	/// Max vertex count.
+	Int max_vertex_count;
+
+	/// Distance between components of vertex in elements.
+	Int pitch;
+
+	/// Vertex X, Y, Z arrays.
+	vector<Fixed> v_xyz;
+
+	/// Vertex normal X, Y, Z arrays.
+	vector<Fixed> n_xyz;
+};
+
+#endif // Fixed
+
+} //namespace mdragon
+
+#endif // __MD_VSOA_H__
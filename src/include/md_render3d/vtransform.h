@@ -0,0 +1,350 @@
+/** \file
+ *	Batch vertex transformation and projection. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_VTRANSFORM_H__
+#define __MD_VTRANSFORM_H__
+
+namespace mdragon
+{
+
+#ifndef Fixed
+
+/// Number of vertices processed by TransformVertexBlock().
+#define VertexBlock_Size 8
+
+
+/// Transformation and projection parameters for batch kernels.
+/**
+ *	Projection follows Render3D: camera looks along -Z, view space vertex
+ *	is negated and then projected by TRANSFORM_VERTEXf() and
+ *	PROJECT_VERTEX(), so vertices in front of camera have negative view Z.
+ */
+class VertexTransform
+{
+public:
+
+	/// Sets parameters.
+	/**
+	 *	@param m - view * world matrix.
+	 *	@param x_perspective_, y_perspective_ - perspective scale, as passed to TRANSFORM_VERTEXf().
+	 *	@param width2_, height2_, x_, y_ - viewport, as passed to PROJECT_VERTEX().
+	 *	@param z_near_, z_far_ - distances from camera to near and far planes.
+	 */
+	void Set( const Matrix4fx& m, Int x_perspective_, Int y_perspective_,
+			Int width2_, Int height2_, Int x_, Int y_, Int z_near_, Int z_far_ )
+	{
+		matrix[0] = m._11.value; matrix[1] = m._12.value; matrix[2] = m._13.value; matrix[3] = m._14.value;
+		matrix[4] = m._21.value; matrix[5] = m._22.value; matrix[6] = m._23.value; matrix[7] = m._24.value;
+		matrix[8] = m._31.value; matrix[9] = m._32.value; matrix[10] = m._33.value; matrix[11] = m._34.value;
+
+		x_perspective = x_perspective_;
+		y_perspective = y_perspective_;
+		width2 = width2_;
+		height2 = height2_;
+		x = x_;
+		y = y_;
+		z_near = z_near_;
+		z_far = z_far_;
+	}
+
+	/// Sets parameters from current world matrix, camera and viewport of render.
+	void Set( Render3D& render )
+	{
+		Set( render.GetViewWorld(), render.RenderXPerspective, render.RenderYPerspective,
+				render.RenderWidth2, render.RenderHeight2, render.RenderX, render.RenderY,
+				render.RenderZNear, render.RenderZFar );
+	}
+
+	/// First three rows of matrix, 16.16 fixed point.
+	Int matrix[12];
+
+	Int x_perspective, y_perspective;
+	Int width2, height2, x, y;
+	Int z_near, z_far;
+};
+
+
+/// Vertices processed by TransformVertexBlock(), one array per channel.
+class VertexBlock
+{
+public:
+
+	/// Source vertices.
+	Int x[VertexBlock_Size], y[VertexBlock_Size], z[VertexBlock_Size];
+
+	/// View space vertices.
+	Int vx[VertexBlock_Size], vy[VertexBlock_Size], vz[VertexBlock_Size];
+
+	/// Perspective divided vertices, pz holds 1/z.
+	Int px[VertexBlock_Size], py[VertexBlock_Size], pz[VertexBlock_Size];
+
+	/// Screen positions.
+	Int sx[VertexBlock_Size], sy[VertexBlock_Size];
+
+	/// Render_XXX_Plane flags of planes vertex is outside of.
+	Int clip[VertexBlock_Size];
+};
+
+
+/// Transforms S::Width vertices of block starting at i.
+/**
+ *	Per vertex the result is the same as world to view transformation by
+ *	FixedMul(), negation, TRANSFORM_VERTEXf() and ROUND() of
+ *	PROJECT_VERTEX(). Vertices less than 4 units in front of camera can
+ *	not be divided; they get zero projected and screen values and
+ *	Render_Near_Plane flag.
+ */
+template<class S>
+inline void TransformVertexLanes( const VertexTransform& t, const Int* x_, const Int* y_, const Int* z_, VertexBlock& b, Int i )
+{
+	typedef typename S::V V;
+
+	V x = S::Load( x_ + i );
+	V y = S::Load( y_ + i );
+	V z = S::Load( z_ + i );
+
+	const Int* m = t.matrix;
+
+	V vx = S::Add( S::Add( S::MulFixed( x, S::Set( m[0] ) ), S::MulFixed( y, S::Set( m[1] ) ) ),
+			S::Add( S::MulFixed( z, S::Set( m[2] ) ), S::Set( m[3] ) ) );
+	V vy = S::Add( S::Add( S::MulFixed( x, S::Set( m[4] ) ), S::MulFixed( y, S::Set( m[5] ) ) ),
+			S::Add( S::MulFixed( z, S::Set( m[6] ) ), S::Set( m[7] ) ) );
+	V vz = S::Add( S::Add( S::MulFixed( x, S::Set( m[8] ) ), S::MulFixed( y, S::Set( m[9] ) ) ),
+			S::Add( S::MulFixed( z, S::Set( m[10] ) ), S::Set( m[11] ) ) );
+
+	// Camera looks along -Z, Render3D negates vertex before projection.
+	V zero = S::Set( 0 );
+	V ex = S::Sub( zero, vx );
+	V ey = S::Sub( zero, vy );
+	V ez = S::Sub( zero, vz );
+
+	// FDiv14x2( 1<<16, ez ) for divisible lanes.
+	V d = S::Sra( ez, 2 );
+	V valid = S::CmpGt( d, zero );
+	V pz = S::And( S::Recip30( S::Select( valid, d, S::Set( 1 ) ) ), valid );
+
+	// FMul8x8( FMul8x0( e, pz ), perspective ).
+	V px = S::MulLo( S::Sra( S::Sra( S::MulLo( S::Sra( ex, 8 ), pz ), 8 ), 8 ), S::Set( t.x_perspective >> 8 ) );
+	V py = S::MulLo( S::Sra( S::Sra( S::MulLo( S::Sra( ey, 8 ), pz ), 8 ), 8 ), S::Set( t.y_perspective >> 8 ) );
+
+	// ROUND( ( -px + I2F(1) ) * width2 ) + x, ROUND( ( py + I2F(1) ) * height2 ) + y.
+	V one = S::Set( I2F(1) );
+	V half = S::Set( HALF );
+	V sx = S::MulLo( S::Sub( one, px ), S::Set( t.width2 ) );
+	V sy = S::MulLo( S::Add( py, one ), S::Set( t.height2 ) );
+	V sx_neg = S::CmpGt( zero, sx );
+	V sy_neg = S::CmpGt( zero, sy );
+	sx = S::Add( S::Sra( S::Add( sx, S::Select( sx_neg, S::Set( -HALF ), half ) ), 16 ), S::Set( t.x ) );
+	sy = S::Add( S::Sra( S::Add( sy, S::Select( sy_neg, S::Set( -HALF ), half ) ), 16 ), S::Set( t.y ) );
+	sx = S::And( sx, valid );
+	sy = S::And( sy, valid );
+
+	V minus_one = S::Set( -I2F(1) );
+	V clip = S::Select( valid, S::And( S::CmpGt( S::Set( t.z_near ), ez ), S::Set( Render_Near_Plane ) ), S::Set( Render_Near_Plane ) );
+	clip = S::Or( clip, S::And( S::CmpGt( ez, S::Set( t.z_far ) ), S::Set( Render_Far_Plane ) ) );
+	clip = S::Or( clip, S::And( valid, S::Or(
+			S::Or( S::And( S::CmpGt( px, one ), S::Set( Render_Left_Plane ) ),
+				S::And( S::CmpGt( minus_one, px ), S::Set( Render_Right_Plane ) ) ),
+			S::Or( S::And( S::CmpGt( minus_one, py ), S::Set( Render_Top_Plane ) ),
+				S::And( S::CmpGt( py, one ), S::Set( Render_Bottom_Plane ) ) ) ) ) );
+
+	S::Store( b.vx + i, vx );
+	S::Store( b.vy + i, vy );
+	S::Store( b.vz + i, vz );
+	S::Store( b.px + i, px );
+	S::Store( b.py + i, py );
+	S::Store( b.pz + i, pz );
+	S::Store( b.sx + i, sx );
+	S::Store( b.sy + i, sy );
+	S::Store( b.clip + i, clip );
+}
+
+
+/// Transforms VertexBlock_Size vertices given by component arrays.
+/**
+ *	@param t - transformation parameters.
+ *	@param x, y, z - source component arrays, VertexBlock_Size elements each.
+ *	@param b - vertex block receiving results, source fields are not used.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ */
+inline void TransformVertexBlock( const VertexTransform& t, const Int* x, const Int* y, const Int* z, VertexBlock& b, Bool simd = True )
+{
+#ifdef MD_SIMD
+	if( simd )
+	{
+		for( Int i = 0; i < VertexBlock_Size; i += SimdNative::Width )
+			TransformVertexLanes<SimdNative>( t, x, y, z, b, i );
+		return;
+	}
+#endif
+
+	for( Int i = 0; i < VertexBlock_Size; i++ )
+		TransformVertexLanes<SimdScalar>( t, x, y, z, b, i );
+}
+
+/// Transforms all VertexBlock_Size vertices of block.
+/**
+ *	@param t - transformation parameters.
+ *	@param b - vertex block, x, y, z must be filled.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ */
+inline void TransformVertexBlock( const VertexTransform& t, VertexBlock& b, Bool simd = True )
+{
+	TransformVertexBlock( t, b.x, b.y, b.z, b, simd );
+}
+
+/// Copies first n results of block to output arrays of TransformVertexBatch().
+inline void StoreVertexBlock( const VertexBlock& b, Int n, Int*& view_xyz, Int*& proj_xyz, Int*& screen_xy, Byte*& clip )
+{
+	for( Int j = 0; j < n; j++ )
+	{
+		if( view_xyz )
+		{
+			*view_xyz++ = b.vx[j];
+			*view_xyz++ = b.vy[j];
+			*view_xyz++ = b.vz[j];
+		}
+
+		if( proj_xyz )
+		{
+			*proj_xyz++ = b.px[j];
+			*proj_xyz++ = b.py[j];
+			*proj_xyz++ = b.pz[j];
+		}
+
+		if( screen_xy )
+		{
+			*screen_xy++ = b.sx[j];
+			*screen_xy++ = b.sy[j];
+		}
+
+		if( clip )
+			*clip++ = (Byte)b.clip[j];
+	}
+}
+
+
+/// Transforms, projects and clip tests array of vertices.
+/**
+ *	Vertices are processed by VertexBlock_Size using SIMD instructions if
+ *	available, results are bit-identical to scalar code.
+ *	@param t - transformation parameters.
+ *	@param v_xyz - source vertices, for example VertexBuffer Vxyz channel.
+ *	@param v_stride - distance between source vertices in Int.
+ *	@param count - number of vertices.
+ *	@param view_xyz - receives view space vertices, 3 Int per vertex. May be NULL.
+ *	@param proj_xyz - receives perspective divided x, y and 1/z, 3 Int per vertex. May be NULL.
+ *	@param screen_xy - receives screen x, y, 2 Int per vertex. May be NULL.
+ *	@param clip - receives Render_XXX_Plane flags. May be NULL.
+ *	@param simd - False to use scalar code even if SIMD is available.
+ */
+inline void TransformVertexBatch( const VertexTransform& t, const Int* v_xyz, Int v_stride, Int count,
+		Int* view_xyz, Int* proj_xyz, Int* screen_xy, Byte* clip, Bool simd = True )
+{
+	RENDER3D_PROFILE_SCOPE( Render3D_Stage_Transform )
+	RENDER3D_PROFILE_COUNT( vertices_transformed, count )
+
+	VertexBlock b;
+
+	for( Int i = 0; i < count; i += VertexBlock_Size )
+	{
+		Int n = min( count - i, VertexBlock_Size );
+		const Int* v = v_xyz + i * v_stride;
+		Int j;
+
+		for( j = 0; j < n; j++, v += v_stride )
+		{
+			b.x[j] = v[0];
+			b.y[j] = v[1];
+			b.z[j] = v[2];
+		}
+
+		for( ; j < VertexBlock_Size; j++ )
+			b.x[j] = b.y[j] = b.z[j] = 0;
+
+		TransformVertexBlock( t, b, simd );
+		StoreVertexBlock( b, n, view_xyz, proj_xyz, screen_xy, clip );
+	}
+}
+
+/// Transforms, projects and clip tests vertices stored as structure of arrays.
+/**
+ *	Source is read straight from component arrays without gathering.
+ *	Arrays must be readable up to count rounded up to VertexBlock_Size,
+ *	as VertexBufferSoA arrays are.
+ *	@param x, y, z - source component arrays.
+ *	Other parameters are the same as in TransformVertexBatch().
+ */
+inline void TransformVertexBatchSoA( const VertexTransform& t, const Int* x, const Int* y, const Int* z, Int count,
+		Int* view_xyz, Int* proj_xyz, Int* screen_xy, Byte* clip, Bool simd = True )
+{
+	RENDER3D_PROFILE_SCOPE( Render3D_Stage_Transform )
+	RENDER3D_PROFILE_COUNT( vertices_transformed, count )
+
+	VertexBlock b;
+
+	for( Int i = 0; i < count; i += VertexBlock_Size )
+	{
+		TransformVertexBlock( t, x + i, y + i, z + i, b, simd );
+		StoreVertexBlock( b, min( count - i, VertexBlock_Size ), view_xyz, proj_xyz, screen_xy, clip );
+	}
+}
+
+/// Transforms, projects and clip tests VertexBuffer channel.
+/**
+ *	Uses TransformVertexBatchSoA() for planar channels, see VertexBufferSoA.
+ *	@param v - vertex X, Y, Z channel, see VertexBuffer::GetVxyz() and VertexBufferSoA::GetVxyz().
+ *	Other parameters are the same as in TransformVertexBatch().
+ */
+inline void TransformVertexBatch( const VertexTransform& t, VertexChannel<Fixed> v,
+		Int* view_xyz, Int* proj_xyz, Int* screen_xy, Byte* clip, Bool simd = True )
+{
+	const Int* x = reinterpret_cast<const Int*>( v.Component( 0 ) );
+
+	if( v.IsPlanar() )
+		TransformVertexBatchSoA( t, x, x + v.pitch, x + 2 * v.pitch, v.count, view_xyz, proj_xyz, screen_xy, clip, simd );
+	else
+		TransformVertexBatch( t, x, v.stride, v.count, view_xyz, proj_xyz, screen_xy, clip, simd );
+}
+
+
+/// Checks that TransformVertexBatch() and Render3D::GetScreenRect() project point alike.
+/**
+ *	Point is projected by both paths with current world matrix, camera
+ *	and viewport of render. Used by debug builds of MDGameBenchmark.
+ *	@param render - render giving projection.
+ *	@param pos - point in model coordinates.
+ *	@return False if screen position from TransformVertexBatch() is out of
+ *	rectangle from GetScreenRect(), else True. True for points not in front
+ *	of near plane.
+ */
+inline Bool CheckVertexTransform( Render3D& render, Vector3fx& pos )
+{
+	Int x1, y1, x2, y2, dist;
+	if( !render.GetScreenRect( pos, Fixed( 0, 0 ), x1, y1, x2, y2, dist ) )
+		return True;
+
+	VertexTransform t;
+	t.Set( render );
+
+	Int v[3] = { pos.x.value, pos.y.value, pos.z.value };
+	Int screen[2];
+	Byte clip;
+
+	TransformVertexBatch( t, v, 3, 1, NULL, NULL, screen, &clip, True );
+
+	if( clip & Render_Near_Plane )
+		return True;
+
+	return screen[0] >= x1 && screen[0] <= x2 && screen[1] >= y1 && screen[1] <= y2;
+}
+
+#endif // Fixed
+
+} //namespace mdragon
+
+#endif // __MD_VTRANSFORM_H__
@@ -0,0 +1,298 @@
+/** \file
+ *	Scoped scratch memory built on System pool. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_FRAMEARENA_H__
+#define __MD_FRAMEARENA_H__
+
+namespace mdragon
+{
+
+/// Default size of FrameArena overflow block in bytes.
+#define FrameArena_Overflow_Block_Size ( 16 * 1024 )
+
+/// Default alignment of FrameArena allocations.
+#define FrameArena_Default_Align 4
+
+
+/// Allocation level of FrameArena, returned by FrameArena::Save().
+class FrameArenaMark
+{
+public:
+
+	Int pool_used;
+	Int pool_free;
+	void* block;
+	Int block_used;
+	Int overflow_used;
+};
+
+
+/// Scratch memory for temporaries living inside one frame or one call.
+/**
+ *	Memory is taken from System pool by System::GetPool(). When the pool is
+ *	exhausted the arena continues in overflow blocks allocated by malloc(),
+ *	they are kept and reused until Free(). Memory is released only by
+ *	Restore() to a level returned by Save(), usually through
+ *	FrameArenaScope. Constructors and destructors are not called, so the
+ *	arena is for plain data: indexes, clip polygons, screen coordinates.
+ */
+class FrameArena
+{
+public:
+
+	MD_TRACKED_OBJECT_TAG( FrameArena, MemoryTag_FrameArena )
+
+	/// Constructor.
+	/**
+	 *	@param system_ - System whose pool is used, may be set later by Init().
+	 */
+	FrameArena( System* system_ = NULL )
+	{
+		system = system_;
+		block_size = FrameArena_Overflow_Block_Size;
+		blocks = NULL;
+		current = NULL;
+		overflow_used = 0;
+		overflow_count = 0;
+		peak_size = 0;
+	}
+
+	/// Destructor.
+	~FrameArena()
+	{
+		Free();
+	}
+
+	/// Sets System whose pool is used.
+	/**
+	 *	@param system_ - System object, NULL to use overflow blocks only.
+	 *	@param block_size_ - minimal size of overflow block in bytes.
+	 */
+	void Init( System* system_, Int block_size_ = FrameArena_Overflow_Block_Size )
+	{
+		system = system_;
+		block_size = block_size_;
+	}
+
+	/// Frees overflow blocks. Must not be called while arena memory is used.
+	void Free()
+	{
+		while( blocks )
+		{
+			Block* next = blocks->next;
+			MD_FREE( blocks );
+			blocks = next;
+		}
+
+		current = NULL;
+		overflow_used = 0;
+	}
+
+	/// Returns System the arena works on.
+	inline System* GetSystem() { return system; }
+
+	/// Allocates memory.
+	/**
+	 *	@param size - size in bytes.
+	 *	@param align - alignment, power of two.
+	 *	@return Returns pointer to memory, or NULL if neither System pool nor malloc() has enough memory.
+	 */
+	Byte* Alloc( Int size, Int align = FrameArena_Default_Align )
+	{
+		Byte* p = NULL;
+
+		if( system )
+		{
+			p = system->GetPool( size + align - 1 );
+
+			if( p )
+			{
+				UpdatePeak();
+				return Align( p, align );
+			}
+		}
+
+		return AllocOverflow( size, align );
+	}
+
+	/// Allocates array of count elements of type T.
+	/**
+	 *	Elements are aligned to the largest power of two dividing sizeof(T),
+	 *	at most 32. Elements are not constructed.
+	 *	@param count - number of elements.
+	 *	@return Returns pointer to the first element, or NULL if out of memory.
+	 */
+	template<class T>
+	inline T* Alloc( Int count )
+	{
+		Int align = sizeof(T) & ( 0 - sizeof(T) );
+		return reinterpret_cast<T*>( Alloc( sizeof(T) * count, align < FrameArena_Default_Align ? FrameArena_Default_Align : ( align > 32 ? 32 : align ) ) );
+	}
+
+	/// Returns current allocation level.
+	FrameArenaMark Save()
+	{
+		FrameArenaMark mark;
+
+		if( system )
+			system->SavePool( &mark.pool_used, &mark.pool_free );
+		else
+			mark.pool_used = mark.pool_free = 0;
+
+		mark.block = current;
+		mark.block_used = current ? current->used : 0;
+		mark.overflow_used = overflow_used;
+
+		return mark;
+	}
+
+	/// Releases all memory allocated after Save() returned mark.
+	void Restore( const FrameArenaMark& mark )
+	{
+		if( system )
+			system->RestorePool( mark.pool_used, mark.pool_free );
+
+		current = (Block*)mark.block;
+		if( current )
+			current->used = mark.block_used;
+
+		overflow_used = mark.overflow_used;
+	}
+
+	/// Returns maximal used size since ResetPeak(), System pool and overflow blocks together.
+	inline Int GetPeakSize() { return peak_size; }
+
+	/// Returns size of overflow blocks in use.
+	inline Int GetOverflowSize() { return overflow_used; }
+
+	/// Returns number of allocations served by overflow blocks since ResetPeak().
+	inline Int GetOverflowCount() { return overflow_count; }
+
+	/// Sets peak size to currently used size and zeroes overflow counter.
+	inline void ResetPeak()
+	{
+		peak_size = 0;
+		overflow_count = 0;
+		UpdatePeak();
+	}
+
+private:
+
+	/// Overflow block header, data follows it.
+	struct Block
+	{
+		Block* next;
+		Int size;
+		Int used;
+	};
+
+	static inline Byte* Align( Byte* p, Int align )
+	{
+		return p + (Int)( ( 0 - (Long)p ) & ( align - 1 ) );
+	}
+
+	Byte* AllocOverflow( Int size, Int align )
+	{
+		Int need = size + align - 1;
+
+		// Next block is the one after current, or the first if nothing is used.
+		Block* b = current;
+
+		if( !b || b->size - b->used < need )
+		{
+			Block* prev = b;
+			b = b ? b->next : blocks;
+
+			while( b && b->size < need )
+			{
+				prev = b;
+				b = b->next;
+			}
+
+			if( !b )
+			{
+				Int n = need > block_size ? need : block_size;
+
+				MD_MEMORY_TAG( MemoryTag_FrameArena )
+				b = (Block*)MD_MALLOC( sizeof(Block) + n );
+				if( !b )
+					return NULL;
+
+				b->size = n;
+				b->next = NULL;
+
+				if( prev )
+					prev->next = b;
+				else
+					blocks = b;
+			}
+
+			b->used = 0;
+			current = b;
+		}
+
+		Byte* p = (Byte*)( b + 1 ) + b->used;
+		b->used += need;
+		overflow_used += need;
+		overflow_count++;
+
+		UpdatePeak();
+		return Align( p, align );
+	}
+
+	inline void UpdatePeak()
+	{
+		Int used = overflow_used + ( system ? system->PoolSize() - system->FreePoolSize() : 0 );
+
+		if( used > peak_size )
+			peak_size = used;
+	}
+
+	System* system;
+	Int block_size;
+
+	Block* blocks;
+	Block* current;
+
+	Int overflow_used;
+	Int overflow_count;
+	Int peak_size;
+};
+
+
+/// Releases FrameArena memory allocated during scope lifetime.
+/**
+ *	\code
+ *	{
+ *		FrameArenaScope scope( arena );
+ *		Int* index = arena.Alloc<Int>( count );
+ *		...
+ *	} // index is released here
+ *	\endcode
+ */
+class FrameArenaScope
+{
+public:
+
+	/// Constructor, saves arena level.
+	FrameArenaScope( FrameArena& arena_ ) : arena( arena_ ), mark( arena_.Save() ) {}
+
+	/// Destructor, restores arena level.
+	~FrameArenaScope() { arena.Restore( mark ); }
+
+private:
+
+	FrameArenaScope( const FrameArenaScope& );
+	FrameArenaScope& operator = ( const FrameArenaScope& );
+
+	FrameArena& arena;
+	FrameArenaMark mark;
+};
+
+} //namespace mdragon
+
+#endif // __MD_FRAMEARENA_H__
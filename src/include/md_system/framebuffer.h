@@ -0,0 +1,268 @@
+/** \file
+ *	Offscreen frame buffer for capturing frames. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_FRAMEBUFFER_H__
+#define __MD_FRAMEBUFFER_H__
+
+namespace mdragon
+{
+
+/* Image formats. Are used in SetDump(), Encode(), Save() functions. */
+
+/// Binary PPM (P6) image, 24 bits per pixel.
+#define FrameBuffer_Format_PPM 1
+
+/// Uncompressed TGA image, 24 bits per pixel.
+#define FrameBuffer_Format_TGA 2
+
+
+/// Offscreen frame buffer.
+/**
+ *	Application copies 4:4:4 Pixel backbuffer lines into it by Present(),
+ *	for example to compare frames by Checksum() on a host without a
+ *	display. Every presented frame can optionally be dumped to PPM or TGA
+ *	file.
+ */
+class FrameBuffer
+{
+public:
+
+	/// Constructor.
+	FrameBuffer()
+	{
+		width = 0;
+		height = 0;
+		frame = 0;
+		dump_format = 0;
+		dump_interval = 0;
+	}
+
+	/// Allocates frame buffer memory.
+	/**
+	 *	@param width_ - frame buffer width in pixels.
+	 *	@param height_ - frame buffer height in pixels.
+	 *	@return True if frame buffer allocated successfully else False.
+	 */
+	Bool Init( Int width_, Int height_ )
+	{
+		if( width_ <= 0 || height_ <= 0 )
+			return False;
+
+		width = width_;
+		height = height_;
+		frame = 0;
+		pixels.resize( width * height, 0 );
+
+		return True;
+	}
+
+	/// Frees frame buffer memory.
+	void Free()
+	{
+		pixels.clear();
+		width = 0;
+		height = 0;
+	}
+
+	/// Returns frame buffer width in pixels.
+	inline Int GetWidth() { return width; }
+
+	/// Returns frame buffer height in pixels.
+	inline Int GetHeight() { return height; }
+
+	/// Returns pointer to the first pixel of the frame buffer.
+	inline Word* GetPixels() { return pixels.begin(); }
+
+	/// Returns number of frames presented since Init().
+	inline DWord GetFrame() { return frame; }
+
+	/// Copies part of backbuffer into frame buffer.
+	/**
+	 *	Counts presented frame and dumps it if SetDump() was called.
+	 *	@param src - pointer to backbuffer pixel (x,y).
+	 *	@param src_pitch - backbuffer line length in pixels.
+	 *	@param x - left position of copied rectangle.
+	 *	@param y - top position of copied rectangle.
+	 *	@param w - width of copied rectangle.
+	 *	@param h - height of copied rectangle.
+	 */
+	void Present( const Word* src, Int src_pitch, Int x, Int y, Int w, Int h )
+	{
+		if( x < 0 ) { src -= x; w += x; x = 0; }
+		if( y < 0 ) { src -= y * src_pitch; h += y; y = 0; }
+		if( x + w > width ) w = width - x;
+		if( y + h > height ) h = height - y;
+
+		if( w > 0 && h > 0 )
+		{
+			Word* dst = GetPixels() + y * width + x;
+
+			for( Int i = 0; i < h; i++, dst += width, src += src_pitch )
+				memcpy( dst, src, w * sizeof(Word) );
+		}
+
+		frame++;
+
+#ifdef MD_OS_LINUX
+		if( dump_format && ( frame % dump_interval ) == 0 )
+		{
+			string file_name = dump_name;
+			file_name << "_" << string( frame ) << ( dump_format == FrameBuffer_Format_TGA ? ".tga" : ".ppm" );
+			Save( file_name.c_str(), dump_format );
+		}
+#endif
+	}
+
+	/// Enables dumping of presented frames.
+	/**
+	 *	@param name_ - file name prefix, frame number and extension will be added.
+	 *	@param format_ - image format, see FrameBuffer_Format_XXX defines. 0 disables dump.
+	 *	@param interval_ - dump every interval_'th frame.
+	 */
+	void SetDump( const Char* name_, Int format_, Int interval_ = 1 )
+	{
+		dump_name = name_;
+		dump_format = format_;
+		dump_interval = interval_ > 0 ? interval_ : 1;
+	}
+
+	/// Encodes frame buffer content as image.
+	/**
+	 *	@param res - Resource object to write image to.
+	 *	@param format_ - image format, see FrameBuffer_Format_XXX defines.
+	 *	@return True if encoded successfully else False.
+	 */
+	Bool Encode( Resource& res, Int format_ )
+	{
+		if( pixels.empty() )
+			return False;
+
+		res.Clear();
+
+		if( format_ == FrameBuffer_Format_PPM )
+		{
+			string header = "P6\n";
+			header << string( width ) << " " << string( height ) << "\n255\n";
+			res.Write( header.c_str(), header.size() );
+
+			for( Int y = 0; y < height; y++ )
+				WriteLine( res, y, False );
+
+			return True;
+		}
+
+		if( format_ == FrameBuffer_Format_TGA )
+		{
+			// Uncompressed true color image, origin at top left.
+			Byte header[18];
+			memset( header, 0, sizeof(header) );
+			header[2] = 2;
+			header[12] = (Byte)( width & 0xFF );
+			header[13] = (Byte)( width >> 8 );
+			header[14] = (Byte)( height & 0xFF );
+			header[15] = (Byte)( height >> 8 );
+			header[16] = 24;
+			header[17] = 0x20;
+			res.Write( header, 18 );
+
+			for( Int y = 0; y < height; y++ )
+				WriteLine( res, y, True );
+
+			return True;
+		}
+
+		return False;
+	}
+
+#ifdef MD_OS_LINUX
+
+	/// Saves frame buffer content to image file.
+	/**
+	 *	@param file_name - image file name.
+	 *	@param format_ - image format, see FrameBuffer_Format_XXX defines.
+	 *	@return True if saved successfully else False.
+	 */
+	Bool Save( const Char* file_name, Int format_ )
+	{
+		Resource res;
+
+		if( !Encode( res, format_ ) )
+			return False;
+
+		FILE* file = fopen( file_name, "wb" );
+		if( !file )
+			return False;
+
+		Bool ok = fwrite( res.GetData(), 1, res.Size(), file ) == (size_t)res.Size();
+		fclose( file );
+
+		return ok;
+	}
+
+#endif // MD_OS_LINUX
+
+	/// Returns checksum of frame buffer content.
+	/**
+	 *	Used to compare frames rendered by different builds.
+	 *	@return 32 bit FNV-1a hash of all pixels.
+	 */
+	DWord Checksum()
+	{
+		DWord hash = 2166136261U;
+		const Byte* p = reinterpret_cast<const Byte*>( GetPixels() );
+		const Byte* e = p + pixels.size() * sizeof(Word);
+
+		for( ; p != e; ++p )
+			hash = ( hash ^ *p ) * 16777619U;
+
+		return hash;
+	}
+
+private:
+
+	/// Writes one line of pixels as 24 bit RGB or BGR.
+	void WriteLine( Resource& res, Int y, Bool bgr )
+	{
+		Byte line[3 * 256];
+		const Word* src = GetPixels() + y * width;
+
+		for( Int x = 0; x < width; )
+		{
+			Int n = min( width - x, 256 );
+
+			for( Int i = 0; i < n; i++, src++ )
+			{
+				// Expand 4 bit color components to 8 bits.
+				Byte r = (Byte)( ( ( *src >> 8 ) & 0xF ) * 17 );
+				Byte g = (Byte)( ( ( *src >> 4 ) & 0xF ) * 17 );
+				Byte b = (Byte)( ( *src & 0xF ) * 17 );
+
+				line[i*3] = bgr ? b : r;
+				line[i*3+1] = g;
+				line[i*3+2] = bgr ? r : b;
+			}
+
+			res.Write( line, n * 3 );
+			x += n;
+		}
+	}
+
+	Int width;
+	Int height;
+
+	vector<Word> pixels;
+
+	DWord frame;
+
+	string dump_name;
+	Int dump_format;
+	Int dump_interval;
+};
+
+} //namespace mdragon
+
+#endif // __MD_FRAMEBUFFER_H__
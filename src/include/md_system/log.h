@@ -91,6 +91,10 @@ private:
 	string file_name;
 #endif
 
+#if defined(MD_OS_LINUX)
+	void* file; // FILE*
+#endif
+
 };
 
 } //namespace mdragon
@@ -0,0 +1,476 @@
+/** \file
+ *	Allocation tracking and memory report. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_MEMTRACK_H__
+#define __MD_MEMTRACK_H__
+
+namespace mdragon
+{
+
+/* Memory tags. Owner of allocation, see MD_MEMORY_TAG(). */
+
+/// Untagged allocation.
+#define MemoryTag_Other					0
+
+/// Object of class with MD_TRACKED_OBJECT().
+#define MemoryTag_Object				1
+
+/// FrameArena block.
+#define MemoryTag_FrameArena			2
+
+/// Render3D helper object of header code, like SceneBVH or HiZBuffer.
+#define MemoryTag_Render3D				3
+
+/// First tag free for application.
+#define MemoryTag_User					4
+
+/// Number of memory tags.
+#define MemoryTag_Count					8
+
+/// Maximal number of live allocations tracked by MemoryTracker.
+#define MemoryTracker_Max_Blocks		8192
+
+/// Maximal depth of MemoryTracker tag stack.
+#define MemoryTracker_Max_Tags			16
+
+/// Maximal number of call sites listed in leak report.
+#define MemoryTracker_Report_Sites		32
+
+#define MD_MEMORY_STRINGIZE2(x) #x
+#define MD_MEMORY_STRINGIZE(x) MD_MEMORY_STRINGIZE2(x)
+
+/// Call site tag of current source line.
+#define MD_MEMORY_SITE __FILE__ ":" MD_MEMORY_STRINGIZE(__LINE__)
+
+
+/// Live totals of one memory tag.
+class MemoryTagStats
+{
+public:
+
+	/// Allocated bytes.
+	Int bytes;
+
+	/// Allocated blocks.
+	Int blocks;
+
+	/// Maximal allocated bytes.
+	Int peak_bytes;
+
+	/// Number of allocations since start.
+	Int total_blocks;
+};
+
+
+/// Records allocations for leak and growth reports.
+/**
+ *	Every tracked allocation keeps size, call site, memory tag and time.
+ *	Objects are allocations made by operator new of MD_TRACKED_OBJECT()
+ *	classes, other allocations are memory blocks.
+ *	Allocations are tagged by the innermost MD_MEMORY_TAG() scope. Records
+ *	are kept in static table of MemoryTracker_Max_Blocks entries, so the
+ *	tracker itself never allocates; allocations above the limit are only
+ *	counted. Report() writes totals per tag, live blocks grouped by call
+ *	site with age of the oldest one, block size histogram, object pools
+ *	and live objects with their tag and age.
+ *	Only allocations made by MD_MALLOC() and objects of classes with
+ *	MD_TRACKED_OBJECT() are recorded, allocations inside engine library
+ *	are not. Tracking is compiled only if MD_MEMORY_TRACKING is defined.
+ */
+class MemoryTracker
+{
+public:
+
+	/// Returns tracker instance.
+	static MemoryTracker& Instance()
+	{
+		static MemoryTracker tracker;
+		return tracker;
+	}
+
+	/// Records new allocation.
+	/**
+	 *	@param p - allocated block, NULL is ignored.
+	 *	@param size - block size.
+	 *	@param site - call site, static string like MD_MEMORY_SITE.
+	 *	@param object - True for object of MD_TRACKED_OBJECT() class.
+	 */
+	void OnAlloc( void* p, Int size, const Char* site, Bool object = False )
+	{
+		if( !p )
+			return;
+
+		Int tag = GetTag();
+		MemoryTagStats& st = tags[tag];
+
+		st.bytes += size;
+		st.blocks++;
+		st.total_blocks++;
+		if( st.bytes > st.peak_bytes )
+			st.peak_bytes = st.bytes;
+
+		Block* b = Find( p, True );
+		if( !b )
+		{
+			untracked++;
+			return;
+		}
+
+		b->p = p;
+		b->size = size;
+		b->site = site;
+		b->tag = tag;
+		b->object = object;
+		b->time = GetMicroTickCount();
+		b->serial = NextSerial();
+		block_count++;
+	}
+
+	/// Records freeing of allocation.
+	/**
+	 *	@param p - freed block, NULL and untracked blocks are ignored.
+	 */
+	void OnFree( void* p )
+	{
+		if( !p )
+			return;
+
+		Block* b = Find( p, False );
+		if( !b )
+			return;
+
+		tags[b->tag].bytes -= b->size;
+		tags[b->tag].blocks--;
+
+		b->p = Deleted();
+		block_count--;
+	}
+
+	/// Records reallocation.
+	void OnRealloc( void* old_p, void* p, Int size, const Char* site )
+	{
+		if( old_p && !p && size )
+			return;
+
+		OnFree( old_p );
+		OnAlloc( p, size, site );
+	}
+
+	/// Makes tag current for following allocations, see MD_MEMORY_TAG().
+	inline void PushTag( Int tag )
+	{
+		if( tag_depth < MemoryTracker_Max_Tags )
+			tag_stack[tag_depth] = tag;
+		tag_depth++;
+	}
+
+	/// Restores previous tag.
+	inline void PopTag()
+	{
+		if( tag_depth > 0 )
+			tag_depth--;
+	}
+
+	/// Returns current tag.
+	inline Int GetTag()
+	{
+		return tag_depth > 0 ? tag_stack[ min( tag_depth, (Int)MemoryTracker_Max_Tags ) - 1 ] : MemoryTag_Other;
+	}
+
+	/// Returns live totals of tag.
+	inline const MemoryTagStats& GetStats( Int tag ) { return tags[tag]; }
+
+	/// Returns new serial number.
+	inline DWord NextSerial() { return ++serial; }
+
+	/// Returns serial number of the last allocation.
+	/**
+	 *	Pass it to Report() to list only allocations made later, for
+	 *	example since level start.
+	 */
+	inline DWord GetSerial() { return serial; }
+
+	/// Writes memory report.
+	/**
+	 *	@param log - log to write to.
+	 *	@param since_serial - list only allocations made after GetSerial() returned this value.
+	 */
+	void Report( Log& log, DWord since_serial = 0 )
+	{
+		static const Char* tag_names[MemoryTag_User] = { "other", "object", "framearena", "render3d" };
+
+		DWord now = GetMicroTickCount();
+
+		log << "Memory report\n";
+		log << "free memory: " << string( (Int)GetFreeMemory() ) << "\n";
+
+		for( Int t = 0; t < MemoryTag_Count; t++ )
+		{
+			const MemoryTagStats& st = tags[t];
+			if( t >= MemoryTag_User && !st.total_blocks )
+				continue;
+
+			log << TagName( tag_names, t );
+			log << ": " << string( st.bytes ) << " bytes in " << string( st.blocks )
+				<< " blocks, peak " << string( st.peak_bytes ) << ", total " << string( st.total_blocks ) << " allocations\n";
+		}
+
+		if( untracked )
+			log << "untracked allocations: " << string( untracked ) << "\n";
+
+		// Live allocations grouped by call site.
+		const Char* sites[MemoryTracker_Report_Sites];
+		Int site_bytes[MemoryTracker_Report_Sites];
+		Int site_blocks[MemoryTracker_Report_Sites];
+		DWord site_time[MemoryTracker_Report_Sites];
+		Int site_count = 0;
+
+		// Block size histogram by powers of two, shows fragmentation.
+		Int histogram[32];
+		memset( histogram, 0, sizeof(histogram) );
+
+		for( Int i = 0; i < MemoryTracker_Max_Blocks; i++ )
+		{
+			Block& b = table[i];
+			if( !b.p || b.p == Deleted() || b.serial <= since_serial || b.object )
+				continue;
+
+			Int bits = 0;
+			while( bits < 31 && ( 1 << bits ) < b.size )
+				bits++;
+			histogram[bits]++;
+
+			Int s = 0;
+			while( s < site_count && strcmp( sites[s], b.site ? b.site : "?" ) )
+				s++;
+
+			if( s == site_count )
+			{
+				if( site_count == MemoryTracker_Report_Sites )
+					continue;
+
+				sites[s] = b.site ? b.site : "?";
+				site_bytes[s] = site_blocks[s] = 0;
+				site_time[s] = b.time;
+				site_count++;
+			}
+
+			site_bytes[s] += b.size;
+			site_blocks[s]++;
+			if( (Int)( b.time - site_time[s] ) < 0 )
+				site_time[s] = b.time;
+		}
+
+		log << "live allocations by site:\n";
+		for( Int s = 0; s < site_count; s++ )
+			log << "  " << sites[s] << ": " << string( site_bytes[s] ) << " bytes in " << string( site_blocks[s] )
+				<< " blocks, oldest " << string( (Int)( ( now - site_time[s] ) / 1000 ) ) << " ms\n";
+
+		log << "live block sizes:\n";
+		for( Int i = 0; i < 32; i++ )
+			if( histogram[i] )
+				log << "  <= " << string( 1 << i ) << ": " << string( histogram[i] ) << "\n";
+
+		log << "object pools:\n";
+		for( ObjectPool* pool = ObjectPool::GetFirst(); pool; pool = pool->GetNext() )
+			log << "  " << pool->GetName() << ": " << string( pool->GetLiveCount() ) << " live, "
+				<< string( pool->GetPeakCount() ) << " peak, " << string( pool->GetSlabCount() ) << " slabs\n";
+
+		log << "live objects:\n";
+		for( Int i = 0; i < MemoryTracker_Max_Blocks; i++ )
+		{
+			Block& b = table[i];
+			if( !b.p || b.p == Deleted() || b.serial <= since_serial || !b.object )
+				continue;
+
+			log << "  #" << string( (Int)b.serial ) << " " << b.site << " " << string( b.size ) << " bytes, "
+				<< TagName( tag_names, b.tag ) << ", age " << string( (Int)( ( now - b.time ) / 1000 ) ) << " ms\n";
+		}
+	}
+
+	/// Finds and reports reference cycles.
+	/**
+	 *	Runs ObjectGraph::FindCycles() and writes every cycle with number
+	 *	of objects and reference counter of each. Size is not reported:
+	 *	rooms, portals and scene nodes are allocated by the engine library
+	 *	and never reach the tracker.
+	 *	@param log - log to write to.
+	 *	@param graph - references filled by caller, see AddRoomReferences().
+	 *	@return Returns number of cycles.
+	 */
+	Int ReportCycles( Log& log, ObjectGraph& graph )
+	{
+		Int cycles = graph.FindCycles();
+
+		for( Int c = 0; c < cycles; c++ )
+		{
+			Int count = graph.GetCycleSize( c );
+
+			log << "cycle of " << string( count ) << " objects, references:";
+			for( Int i = 0; i < count; i++ )
+				log << " " << string( (Int)graph.GetCycleObject( c, i )->GetRefCount() );
+			log << "\n";
+		}
+
+		log << "reference cycles: " << string( cycles ) << "\n";
+		return cycles;
+	}
+
+private:
+
+	/// Allocation record.
+	struct Block
+	{
+		void* p;
+		const Char* site;
+		Int size;
+		Int tag;
+		Bool object;
+		DWord time;
+		DWord serial;
+	};
+
+	MemoryTracker()
+	{
+		memset( table, 0, sizeof(table) );
+		memset( tags, 0, sizeof(tags) );
+		block_count = 0;
+		untracked = 0;
+		serial = 0;
+		tag_depth = 0;
+	}
+
+	/// Returns name of tag for reports.
+	static inline string TagName( const Char** names, Int tag )
+	{
+		if( tag < MemoryTag_User )
+			return string( names[tag] );
+
+		string s = "user ";
+		s << string( tag - MemoryTag_User );
+		return s;
+	}
+
+	/// Marker of freed table entry.
+	static inline void* Deleted() { return (void*)-1; }
+
+	/// Finds entry of p or free entry to insert p.
+	Block* Find( void* p, Bool insert )
+	{
+		DWord h = (DWord)( (Long)p >> 3 );
+		h ^= h >> 15;
+		h *= 0x2c1b3c6dU;
+		h ^= h >> 12;
+
+		Block* free_entry = NULL;
+
+		for( Int i = 0; i < MemoryTracker_Max_Blocks; i++ )
+		{
+			Block& b = table[ ( h + i ) % MemoryTracker_Max_Blocks ];
+
+			if( b.p == p )
+				return insert ? NULL : &b;
+
+			if( b.p == Deleted() )
+			{
+				if( !free_entry )
+					free_entry = &b;
+			}
+			else
+			if( !b.p )
+				return insert ? ( free_entry ? free_entry : &b ) : NULL;
+		}
+
+		return insert ? free_entry : NULL;
+	}
+
+	Block table[MemoryTracker_Max_Blocks];
+	MemoryTagStats tags[MemoryTag_Count];
+
+	Int block_count;
+	Int untracked;
+	DWord serial;
+
+	Int tag_stack[MemoryTracker_Max_Tags];
+	Int tag_depth;
+};
+
+
+/// Makes memory tag current during scope lifetime.
+class MemoryTagScope
+{
+public:
+
+	/// Constructor, pushes tag.
+	MemoryTagScope( Int tag ) { MemoryTracker::Instance().PushTag( tag ); }
+
+	/// Destructor, pops tag.
+	~MemoryTagScope() { MemoryTracker::Instance().PopTag(); }
+};
+
+
+#ifdef MD_MEMORY_TRACKING
+
+/// Tags allocations until end of scope by given MemoryTag_XXX.
+#define MD_MEMORY_TAG(tag) mdragon::MemoryTagScope memory_tag_scope( (tag) );
+
+/// Allocates memory by malloc() and records it with call site.
+#define MD_MALLOC(size) mdragon::TrackedMalloc( (size), MD_MEMORY_SITE )
+
+/// Frees memory allocated by MD_MALLOC().
+#define MD_FREE(p) mdragon::TrackedFree( (p) )
+
+/// Records objects of class in MemoryTracker with given tag, place in class declaration.
+/**
+ *	Objects created by new are allocated by malloc() and recorded with
+ *	class name as call site, Report() lists them as live objects. Objects
+ *	on stack or inside other objects are not recorded. Use only for
+ *	classes whose destructor is defined in header, destructors compiled in
+ *	engine library free objects by global operator delete. Do not combine
+ *	with MD_OBJECT_POOL().
+ */
+#define MD_TRACKED_OBJECT_TAG(Class,tag) \
+	static void* operator new( MD_OBJECT_POOL_SIZE_T size ) \
+	{ \
+		MD_MEMORY_TAG( tag ) \
+		void* p = mdragon::malloc( (Int)size ); \
+		mdragon::MemoryTracker::Instance().OnAlloc( p, (Int)size, #Class, True ); \
+		return p; \
+	} \
+	static void operator delete( void* p ) { mdragon::TrackedFree( p ); }
+
+/// Records objects of class in MemoryTracker with MemoryTag_Object tag, see MD_TRACKED_OBJECT_TAG().
+#define MD_TRACKED_OBJECT(Class) MD_TRACKED_OBJECT_TAG( Class, MemoryTag_Object )
+
+#else
+
+#define MD_MEMORY_TAG(tag)
+#define MD_MALLOC(size) mdragon::malloc( (size) )
+#define MD_FREE(p) mdragon::free( (p) )
+#define MD_TRACKED_OBJECT_TAG(Class,tag)
+#define MD_TRACKED_OBJECT(Class)
+
+#endif
+
+/// Allocates memory by malloc() and records it in MemoryTracker.
+inline void* TrackedMalloc( Int size, const Char* site )
+{
+	void* p = mdragon::malloc( size );
+	MemoryTracker::Instance().OnAlloc( p, size, site );
+	return p;
+}
+
+/// Frees memory and removes it from MemoryTracker.
+inline void TrackedFree( void* p )
+{
+	MemoryTracker::Instance().OnFree( p );
+	mdragon::free( p );
+}
+
+} //namespace mdragon
+
+#endif // __MD_MEMTRACK_H__
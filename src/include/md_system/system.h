@@ -93,6 +93,14 @@ public:
 	 *	@param size - define size of memory hex dump.
 	 */
 	inline void LOGHexDump(const void* buffer, Int size);
+
+#ifdef MD_MEMORY_TRACKING
+	/// Writes MemoryTracker report to system log.
+	/**
+	 *	@param since_serial - list only allocations made after MemoryTracker::GetSerial() returned this value.
+	 */
+	inline void LOGMemoryReport( DWord since_serial = 0 ) { MemoryTracker::Instance().Report( *log, since_serial ); }
+#endif
 	
 	/// Returns system ticks in microseconds.
 	DWord GetTicks() { return ticks; }
@@ -34,6 +34,24 @@ void GetDate(Word* year, Word* month, Word* day);
  */
 DWord GetSystemTickCount();
 
+/**
+ *	GetMicroTickCount() returns high resolution system ticks.
+ *	Use it only to measure time intervals, value wraps about every 71 minutes.
+ *	On MD_OS_LINUX resolution is one microsecond, on other platforms it is
+ *	GetSystemTickCount() resolution of one millisecond.
+ *	@return current system ticks in microseconds.
+ */
+inline DWord GetMicroTickCount()
+{
+#if defined(MD_OS_LINUX)
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return (DWord)tv.tv_sec * 1000000 + (DWord)tv.tv_usec;
+#else
+	return GetSystemTickCount() * 1000;
+#endif
+}
+
 } //namespace mdragon
 
 #endif // __MD_TIME_H__
@@ -0,0 +1,240 @@
+/** \file
+ *	Worker threads for parallel jobs. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_WORKERPOOL_H__
+#define __MD_WORKERPOOL_H__
+
+namespace mdragon
+{
+
+/// Maximal number of threads in WorkerPool.
+#define WorkerPool_Max_Threads 16
+
+
+/// Job executed by WorkerPool.
+class WorkerJob
+{
+public:
+
+	virtual ~WorkerJob() {}
+
+	/// Executes one part of the job.
+	/**
+	 *	Different parts are executed in parallel, so Execute() must
+	 *	write only to data owned by given part.
+	 *	@param index - part number, from 0 to count-1 passed to WorkerPool::Run().
+	 *	@param thread - number of executing thread, from 0 to WorkerPool::GetThreadCount()-1.
+	 */
+	virtual void Execute( Int index, Int thread ) = 0;
+};
+
+
+/// Pool of worker threads.
+/**
+ *	Threads are created only on hosts supporting them (MD_OS_LINUX).
+ *	On other hosts all jobs are executed by the calling thread.
+ *	Calling thread always takes part in job execution and has number 0.
+ */
+class WorkerPool
+{
+public:
+
+	/// Constructor.
+	WorkerPool()
+	{
+		thread_count = 1;
+
+#ifdef MD_OS_LINUX
+		job = NULL;
+		job_count = 0;
+		job_next = 0;
+		job_done = 0;
+		generation = 0;
+		quit = False;
+		pthread_mutex_init( &mutex, NULL );
+		pthread_cond_init( &job_cond, NULL );
+		pthread_cond_init( &done_cond, NULL );
+#endif
+	}
+
+	/// Destructor. Stops worker threads.
+	~WorkerPool()
+	{
+		Free();
+
+#ifdef MD_OS_LINUX
+		pthread_cond_destroy( &done_cond );
+		pthread_cond_destroy( &job_cond );
+		pthread_mutex_destroy( &mutex );
+#endif
+	}
+
+	/// Starts worker threads.
+	/**
+	 *	@param count - total number of threads including calling thread.
+	 *	@return True if all threads started else False. Pool stays usable
+	 *	with the threads started before failure.
+	 */
+	Bool Init( Int count )
+	{
+		Free();
+
+		if( count > WorkerPool_Max_Threads )
+			count = WorkerPool_Max_Threads;
+
+#ifdef MD_OS_LINUX
+		quit = False;
+
+		for( ; thread_count < count; thread_count++ )
+		{
+			args[thread_count].pool = this;
+			args[thread_count].thread = thread_count;
+
+			if( pthread_create( &threads[thread_count], NULL, ThreadProc, &args[thread_count] ) != 0 )
+				return False;
+		}
+#endif
+
+		return count <= thread_count;
+	}
+
+	/// Stops worker threads.
+	void Free()
+	{
+#ifdef MD_OS_LINUX
+		if( thread_count > 1 )
+		{
+			pthread_mutex_lock( &mutex );
+			quit = True;
+			pthread_cond_broadcast( &job_cond );
+			pthread_mutex_unlock( &mutex );
+
+			for( Int i = 1; i < thread_count; i++ )
+				pthread_join( threads[i], NULL );
+		}
+#endif
+
+		thread_count = 1;
+	}
+
+	/// Returns total number of threads including calling thread.
+	inline Int GetThreadCount() { return thread_count; }
+
+	/// Executes all parts of the job and waits for completion.
+	/**
+	 *	Parts are handed out to threads in increasing index order.
+	 *	@param job_ - job to execute.
+	 *	@param count - number of parts.
+	 */
+	void Run( WorkerJob* job_, Int count )
+	{
+#ifdef MD_OS_LINUX
+		if( thread_count > 1 && count > 1 )
+		{
+			pthread_mutex_lock( &mutex );
+			job = job_;
+			job_count = count;
+			job_next = 0;
+			job_done = 0;
+			generation++;
+			pthread_cond_broadcast( &job_cond );
+			pthread_mutex_unlock( &mutex );
+
+			Work( 0 );
+
+			pthread_mutex_lock( &mutex );
+			while( job_done < job_count )
+				pthread_cond_wait( &done_cond, &mutex );
+			job = NULL;
+			pthread_mutex_unlock( &mutex );
+
+			return;
+		}
+#endif
+
+		for( Int i = 0; i < count; i++ )
+			job_->Execute( i, 0 );
+	}
+
+private:
+
+#ifdef MD_OS_LINUX
+
+	struct ThreadArgs
+	{
+		WorkerPool* pool;
+		Int thread;
+	};
+
+	static void* ThreadProc( void* arg )
+	{
+		ThreadArgs* a = (ThreadArgs*)arg;
+		WorkerPool* pool = a->pool;
+		DWord seen = 0;
+
+		for( ;; )
+		{
+			pthread_mutex_lock( &pool->mutex );
+			while( !pool->quit && pool->generation == seen )
+				pthread_cond_wait( &pool->job_cond, &pool->mutex );
+			seen = pool->generation;
+			Bool quit_ = pool->quit;
+			pthread_mutex_unlock( &pool->mutex );
+
+			if( quit_ )
+				return NULL;
+
+			pool->Work( a->thread );
+		}
+	}
+
+	/// Executes parts of current job until none left.
+	void Work( Int thread )
+	{
+		for( ;; )
+		{
+			pthread_mutex_lock( &mutex );
+			if( !job || job_next >= job_count )
+			{
+				pthread_mutex_unlock( &mutex );
+				return;
+			}
+			WorkerJob* j = job;
+			Int index = job_next++;
+			pthread_mutex_unlock( &mutex );
+
+			j->Execute( index, thread );
+
+			pthread_mutex_lock( &mutex );
+			if( ++job_done == job_count )
+				pthread_cond_signal( &done_cond );
+			pthread_mutex_unlock( &mutex );
+		}
+	}
+
+	pthread_t threads[WorkerPool_Max_Threads];
+	ThreadArgs args[WorkerPool_Max_Threads];
+
+	pthread_mutex_t mutex;
+	pthread_cond_t job_cond;
+	pthread_cond_t done_cond;
+
+	WorkerJob* job;
+	Int job_count;
+	Int job_next;
+	Int job_done;
+	DWord generation;
+	Bool quit;
+
+#endif // MD_OS_LINUX
+
+	Int thread_count;
+};
+
+} //namespace mdragon
+
+#endif // __MD_WORKERPOOL_H__
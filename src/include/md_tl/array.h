@@ -27,7 +27,7 @@ public:
 	typedef const T & const_reference;
 	typedef T* pointer;
 	typedef Int difference_type;
-	typedef size_type size_type;
+	typedef mdragon::size_type size_type;
 	typedef array<T,N> self;
 
 
@@ -0,0 +1,591 @@
+/** \file
+ *	Template hash map and hash set classes. <br>
+ *
+ *	Copyright 2005-2006 Herocraft Hitech Co. Ltd.<br>
+ *	Version 1.0 beta.
+ */
+
+#ifndef __MD_HASH_H__
+#define __MD_HASH_H__
+
+namespace mdragon
+{
+
+/// Returns hash of zero terminated string (FNV-1a).
+/**
+ *	Compute it once for names looked up often and pass to find().
+ */
+inline DWord hash_string( const Char * s )
+{
+	DWord h = 2166136261UL;
+	for( ; *s; ++s )
+		h = ( h ^ (Byte)*s ) * 16777619UL;
+	return h;
+}
+
+/// Returns hash of n characters of string (FNV-1a).
+inline DWord hash_string( const Char * s, size_type n )
+{
+	DWord h = 2166136261UL;
+	for( ; n; ++s, --n )
+		h = ( h ^ (Byte)*s ) * 16777619UL;
+	return h;
+}
+
+/// Returns well mixed hash of integer.
+inline DWord hash_int( DWord x )
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6bUL;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35UL;
+	x ^= x >> 16;
+	return x;
+}
+
+/// Hash function object.
+/**
+ *	Default works for integer and enum keys. Specialize for own key types.
+ */
+template<class Key>
+struct hash
+{
+	inline DWord operator () ( const Key & key ) const { return hash_int( (DWord)key ); }
+};
+
+template<class T>
+struct hash<T*>
+{
+	inline DWord operator () ( const T * key ) const { return hash_int( (DWord)( (Long)key >> 2 ) ); }
+};
+
+template<>
+struct hash<const Char*>
+{
+	inline DWord operator () ( const Char * key ) const { return hash_string( key ); }
+};
+
+template<>
+struct hash<string>
+{
+	inline DWord operator () ( const string & key ) const { return hash_string( key.c_str(), key.size() ); }
+
+	/// Allows lookup by plain string without string construction.
+	inline DWord operator () ( const Char * key ) const { return hash_string( key ); }
+};
+
+/// Key equality function object of hash containers.
+/**
+ *	Compares key with any type it has operator == for, so hash_map
+ *	with string keys is searched by const Char * too.
+ */
+template<class Key>
+struct hash_equal
+{
+	template<class Key2>
+	inline Bool operator () ( const Key & a, const Key2 & b ) const { return a == b; }
+};
+
+template<>
+struct hash_equal<const Char*>
+{
+	inline Bool operator () ( const Char * a, const Char * b ) const { return strcmp( a, b ) == 0; }
+};
+
+
+/// Key of hash_set element.
+template<class Value>
+struct hash_identity_key
+{
+	typedef Value key_type;
+	inline const Value & operator () ( const Value & v ) const { return v; }
+};
+
+/// Key of hash_map element.
+template<class Pair>
+struct hash_first_key
+{
+	typedef typename Pair::first_type key_type;
+	inline const key_type & operator () ( const Pair & v ) const { return v.first; }
+};
+
+
+template<class Value, class Table>
+class hash_iterator;
+
+
+/// Open addressing hash table, base of hash_map and hash_set.
+/**
+ *	Elements are kept in one array with linear probing, and hash of every
+ *	element is kept in parallel array, so probing reads few cache lines,
+ *	most mismatches are rejected without key comparison and growth does
+ *	not recompute hashes. Capacity is power of two, table grows when
+ *	it is 3/4 full. Erased slots are marked and reused.
+ *	Iterators and pointers to elements are invalidated by insertion.
+ *	@param Value - element type.
+ *	@param ExtractKey - function object returning key of element.
+ *	@param Hash - hash function object.
+ *	@param Equal - key equality function object.
+ */
+template<class Value, class ExtractKey, class Hash, class Equal>
+class hash_table
+{
+public:
+	typedef typename ExtractKey::key_type key_type;
+	typedef Value value_type;
+	typedef Value & reference;
+	typedef const Value & const_reference;
+	typedef Value * pointer;
+	typedef const Value * const_pointer;
+	typedef mdragon::size_type size_type;
+	typedef hash_table<Value, ExtractKey, Hash, Equal> self;
+	typedef hash_iterator<Value, self> iterator;
+	typedef hash_iterator<const Value, const self> const_iterator;
+
+	/// Default constructor. Creates empty table, memory is allocated on first insertion.
+	inline hash_table()
+	{
+		init();
+	}
+
+	/// Copy constructor.
+	hash_table( const self & src )
+	{
+		init();
+		assign( src );
+	}
+
+	/// Destructor.
+	inline ~hash_table()
+	{
+		clear();
+		delete [] hashes;
+		delete [] raw_buffer;
+	}
+
+	/// The assignment operator.
+	inline self & operator = ( const self & src )
+	{
+		assign( src );
+		return *this;
+	}
+
+	/// Returns number of elements.
+	inline size_type size() const { return data_size; }
+
+	/// Returns True if table holds no elements.
+	inline Bool empty() const { return data_size == 0; }
+
+	/// Returns number of slots.
+	inline size_type capacity() const { return buffer_size; }
+
+	/// Makes room for n elements without growth.
+	inline void reserve( size_type n )
+	{
+		if( n * 4 > buffer_size * 3 )
+			rehash( n );
+	}
+
+	/// Returns an iterator pointing to the first element.
+	inline iterator begin() { return iterator( this, next_slot( 0 ) ); }
+
+	/// Returns a const iterator pointing to the first element.
+	inline const_iterator begin() const { return const_iterator( this, next_slot( 0 ) ); }
+
+	/// Returns an iterator pointing past the last element.
+	inline iterator end() { return iterator( this, buffer_size ); }
+
+	/// Returns a const iterator pointing past the last element.
+	inline const_iterator end() const { return const_iterator( this, buffer_size ); }
+
+	/// Finds element by key.
+	/**
+	 *	@param key - key or any type Hash and Equal accept, like const Char * for string keys.
+	 *	@return Returns iterator to element or end().
+	 */
+	template<class Key2>
+	inline iterator find( const Key2 & key )
+	{
+		return iterator( this, find_slot( key, hash_of( key ) ) );
+	}
+
+	/// Finds element by key.
+	template<class Key2>
+	inline const_iterator find( const Key2 & key ) const
+	{
+		return const_iterator( this, find_slot( key, hash_of( key ) ) );
+	}
+
+	/// Finds element by key and its precomputed hash.
+	/**
+	 *	@param key - key to find.
+	 *	@param key_hash - Hash()( key ), for example hash_string() of name stored at load time.
+	 *	@return Returns iterator to element or end().
+	 */
+	template<class Key2>
+	inline iterator find( const Key2 & key, DWord key_hash )
+	{
+		return iterator( this, find_slot( key, fix_hash( key_hash ) ) );
+	}
+
+	/// Finds element by key and its precomputed hash.
+	template<class Key2>
+	inline const_iterator find( const Key2 & key, DWord key_hash ) const
+	{
+		return const_iterator( this, find_slot( key, fix_hash( key_hash ) ) );
+	}
+
+	/// Returns 1 if element with key exists, 0 otherwise.
+	template<class Key2>
+	inline size_type count( const Key2 & key ) const
+	{
+		return find_slot( key, hash_of( key ) ) != buffer_size ? 1 : 0;
+	}
+
+	/// Inserts element if there is no element with the same key.
+	/**
+	 *	@return Returns iterator to element with the key and True if v was inserted.
+	 */
+	pair<iterator, Bool> insert( const_reference v )
+	{
+		const key_type & key = ExtractKey()( v );
+		DWord h = hash_of( key );
+		size_type i = find_slot( key, h );
+
+		if( i != buffer_size )
+			return pair<iterator, Bool>( iterator( this, i ), False );
+
+		i = insert_slot( h );
+		construct( values() + i, v );
+		return pair<iterator, Bool>( iterator( this, i ), True );
+	}
+
+	/// Removes element by key.
+	/**
+	 *	@return Returns number of removed elements, 0 or 1.
+	 */
+	template<class Key2>
+	size_type erase( const Key2 & key )
+	{
+		size_type i = find_slot( key, hash_of( key ) );
+		if( i == buffer_size )
+			return 0;
+
+		erase_slot( i );
+		return 1;
+	}
+
+	/// Removes element at position pos.
+	inline void erase( iterator pos )
+	{
+		assert( pos.table == this && pos.index < buffer_size && hashes[pos.index] > Deleted );
+		erase_slot( pos.index );
+	}
+
+	/// Removes all elements, memory is kept.
+	void clear()
+	{
+		for( size_type i = 0; i < buffer_size; i++ )
+		{
+			if( hashes[i] > Deleted )
+				destroy( values() + i );
+			hashes[i] = Empty;
+		}
+
+		data_size = 0;
+		used_size = 0;
+	}
+
+	/// Swaps the contents with another table.
+	void swap( self & dst )
+	{
+		mdragon::swap( hashes, dst.hashes );
+		mdragon::swap( raw_buffer, dst.raw_buffer );
+		mdragon::swap( buffer_size, dst.buffer_size );
+		mdragon::swap( data_size, dst.data_size );
+		mdragon::swap( used_size, dst.used_size );
+	}
+
+protected:
+
+	/// Slot marks, hashes of elements are never lower than Busy.
+	enum { Empty = 0, Deleted = 1, Busy = 2 };
+
+	inline Value * values() { return reinterpret_cast<Value*>( raw_buffer ); }
+
+	inline const Value * values() const { return reinterpret_cast<const Value*>( raw_buffer ); }
+
+	static inline DWord fix_hash( DWord h ) { return h < Busy ? h + Busy : h; }
+
+	template<class Key2>
+	inline DWord hash_of( const Key2 & key ) const { return fix_hash( Hash()( key ) ); }
+
+	/// Returns slot of element with key, or buffer_size if not found.
+	template<class Key2>
+	size_type find_slot( const Key2 & key, DWord h ) const
+	{
+		if( !data_size )
+			return buffer_size;
+
+		size_type mask = buffer_size - 1;
+
+		for( size_type i = h & mask; ; i = ( i + 1 ) & mask )
+		{
+			DWord s = hashes[i];
+
+			if( s == Empty )
+				return buffer_size;
+
+			if( s == h && Equal()( ExtractKey()( values()[i] ), key ) )
+				return i;
+		}
+	}
+
+	/// Returns free slot for new element with hash h, marks it busy.
+	size_type insert_slot( DWord h )
+	{
+		if( ( used_size + 1 ) * 4 > buffer_size * 3 )
+			rehash( data_size + 1 );
+
+		size_type mask = buffer_size - 1;
+		size_type i = h & mask;
+
+		while( hashes[i] > Deleted )
+			i = ( i + 1 ) & mask;
+
+		if( hashes[i] == Empty )
+			used_size++;
+
+		hashes[i] = h;
+		data_size++;
+		return i;
+	}
+
+	void erase_slot( size_type i )
+	{
+		destroy( values() + i );
+		hashes[i] = Deleted;
+		data_size--;
+
+		// Deleted slots followed by empty one end no probe chain, free them.
+		size_type mask = buffer_size - 1;
+		if( hashes[ ( i + 1 ) & mask ] == Empty )
+		{
+			while( hashes[i] == Deleted )
+			{
+				hashes[i] = Empty;
+				used_size--;
+				i = ( i - 1 ) & mask;
+			}
+		}
+	}
+
+	/// Returns first occupied slot from i, or buffer_size.
+	inline size_type next_slot( size_type i ) const
+	{
+		while( i < buffer_size && hashes[i] <= Deleted )
+			i++;
+		return i;
+	}
+
+	/// Reallocates table to hold n elements at most half full.
+	void rehash( size_type n )
+	{
+		size_type new_size = 16;
+		while( new_size < n * 2 )
+			new_size *= 2;
+
+		DWord * old_hashes = hashes;
+		Byte * old_buffer = raw_buffer;
+		size_type old_size = buffer_size;
+
+		hashes = new DWord[ new_size ];
+		raw_buffer = new Byte[ sizeof(Value) * new_size ];
+		buffer_size = new_size;
+		used_size = data_size;
+
+		for( size_type i = 0; i < new_size; i++ )
+			hashes[i] = Empty;
+
+		Value * old_values = reinterpret_cast<Value*>( old_buffer );
+		size_type mask = new_size - 1;
+
+		for( size_type i = 0; i < old_size; i++ )
+		{
+			DWord h = old_hashes[i];
+			if( h <= Deleted )
+				continue;
+
+			size_type j = h & mask;
+			while( hashes[j] != Empty )
+				j = ( j + 1 ) & mask;
+
+			hashes[j] = h;
+			relocate( values() + j, old_values + i );
+		}
+
+		delete [] old_hashes;
+		delete [] old_buffer;
+	}
+
+	void assign( const self & src )
+	{
+		if( this == &src )
+			return;
+
+		clear();
+		reserve( src.data_size );
+
+		for( size_type i = 0; i < src.buffer_size; i++ )
+			if( src.hashes[i] > Deleted )
+			{
+				size_type j = insert_slot( src.hashes[i] );
+				construct( values() + j, src.values()[i] );
+			}
+	}
+
+	inline void init()
+	{
+		hashes = NULL;
+		raw_buffer = NULL;
+		buffer_size = 0;
+		data_size = 0;
+		used_size = 0;
+	}
+
+	DWord * hashes;
+	Byte * raw_buffer;
+	size_type buffer_size;
+	size_type data_size;
+
+	/// Number of not empty slots, elements and deleted marks.
+	size_type used_size;
+
+	friend class hash_iterator<Value, self>;
+	friend class hash_iterator<const Value, const self>;
+};
+
+
+/// Forward iterator of hash_table elements.
+template<class Value, class Table>
+class hash_iterator
+{
+public:
+	typedef Value value_type;
+	typedef Value & reference;
+	typedef Value * pointer;
+	typedef mdragon::size_type size_type;
+
+	inline hash_iterator() : table( NULL ), index( 0 ) { ; }
+
+	inline hash_iterator( Table * table_, size_type index_ ) : table( table_ ), index( index_ ) { ; }
+
+	/// Converts iterator to const iterator.
+	template<class Value2, class Table2>
+	inline hash_iterator( const hash_iterator<Value2, Table2> & src ) : table( src.table ), index( src.index ) { ; }
+
+	inline reference operator * () const
+	{
+		assert( table && index < table->buffer_size );
+		return table->values()[index];
+	}
+
+	inline pointer operator -> () const { return &**this; }
+
+	inline hash_iterator & operator ++ ()
+	{
+		index = table->next_slot( index + 1 );
+		return *this;
+	}
+
+	inline hash_iterator operator ++ ( int )
+	{
+		hash_iterator temp = *this;
+		++*this;
+		return temp;
+	}
+
+	inline Bool operator == ( const hash_iterator & src ) const { return index == src.index && table == src.table; }
+
+	inline Bool operator != ( const hash_iterator & src ) const { return !( *this == src ); }
+
+	Table * table;
+	size_type index;
+};
+
+
+/// Associative container of unique keys with mapped values.
+/**
+ *	Open addressing hash table, see hash_table.
+ *	Elements are pair<const Key, T>.
+ *	\code
+ *	hash_map< string, ObjRef<Texture> > textures;
+ *	textures[ "wall" ] = texture;
+ *	hash_map< string, ObjRef<Texture> >::iterator i = textures.find( "wall" );
+ *	if( i != textures.end() )
+ *		texture = i->second;
+ *	\endcode
+ *	@param Key - key type.
+ *	@param T - mapped type.
+ */
+template<class Key, class T, class Hash = hash<Key>, class Equal = hash_equal<Key> >
+class hash_map : public hash_table< pair<const Key, T>, hash_first_key< pair<const Key, T> >, Hash, Equal >
+{
+public:
+	typedef hash_table< pair<const Key, T>, hash_first_key< pair<const Key, T> >, Hash, Equal > base;
+	typedef Key key_type;
+	typedef T mapped_type;
+	typedef typename base::value_type value_type;
+	typedef typename base::iterator iterator;
+	typedef typename base::const_iterator const_iterator;
+	typedef typename base::size_type size_type;
+
+	using base::insert;
+
+	/// Inserts value with key if there is no element with the same key.
+	/**
+	 *	@return Returns iterator to element with the key and True if value was inserted.
+	 */
+	inline pair<iterator, Bool> insert( const Key & key, const T & t )
+	{
+		return insert( value_type( key, t ) );
+	}
+
+	/// Returns reference to value mapped to key, inserts default value if key is not found.
+	T & operator [] ( const Key & key )
+	{
+		DWord h = this->hash_of( key );
+		size_type i = this->find_slot( key, h );
+
+		if( i == this->buffer_size )
+		{
+			i = this->insert_slot( h );
+			construct( this->values() + i, value_type( key, T() ) );
+		}
+
+		return this->values()[i].second;
+	}
+
+	/// Returns pointer to value mapped to key, or NULL if key is not found.
+	template<class Key2>
+	inline T * get( const Key2 & key )
+	{
+		size_type i = this->find_slot( key, this->hash_of( key ) );
+		return i != this->buffer_size ? &this->values()[i].second : NULL;
+	}
+};
+
+
+/// Associative container of unique keys.
+/**
+ *	Open addressing hash table, see hash_table.
+ *	@param Key - key type.
+ */
+template<class Key, class Hash = hash<Key>, class Equal = hash_equal<Key> >
+class hash_set : public hash_table< Key, hash_identity_key<Key>, Hash, Equal >
+{
+};
+
+} //namespace mdragon
+
+#endif // __MD_HASH_H__
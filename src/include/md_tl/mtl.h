@@ -10,12 +10,24 @@
 
 #pragma warning ( disable : 4291 )
 
+#if defined(MD_OS_LINUX)
+
+template<class T>
+void* operator new (size_t, T* ptr)
+{
+	return ptr;
+}
+
+#else
+
 template<class T>
 void* operator new (unsigned int, T* ptr)
 {
 	return ptr;
 }
 
+#endif
+
 namespace mdragon
 {
 
@@ -34,6 +46,11 @@ void mtl_assert(Bool expression, const Char *expression_string,
 	#define assert(expression__)
 #endif
 
+/// Defined if compiler supports rvalue references and variadic templates.
+#if !defined(MD_TL_RVALUE_REFERENCES) && ( __cplusplus >= 201103L || ( defined(_MSC_VER) && _MSC_VER >= 1800 ) )
+	#define MD_TL_RVALUE_REFERENCES
+#endif
+
 } //namespace mdragon
 
 
@@ -18,6 +18,81 @@ void construct( T1 * pointer, const T2& t )
 	new ( pointer ) T1 ( t );
 }
 
+#ifdef MD_TL_RVALUE_REFERENCES
+
+template<class T> struct remove_reference { typedef T type; };
+template<class T> struct remove_reference<T&> { typedef T type; };
+template<class T> struct remove_reference<T&&> { typedef T type; };
+
+/// Casts t to rvalue reference, so it may be moved from.
+template<class T> inline
+typename remove_reference<T>::type && move( T && t )
+{
+	return static_cast<typename remove_reference<T>::type &&>( t );
+}
+
+/// Passes argument keeping it lvalue or rvalue.
+template<class T> inline
+T && forward( typename remove_reference<T>::type & t )
+{
+	return static_cast<T&&>( t );
+}
+
+#endif
+
+/// Type trait, value is True if T may be moved to other address by memcpy().
+/**
+ *	Such objects have no pointers into themselves and nothing else refers
+ *	to their address. Growth and erase of vector of such elements move raw
+ *	memory instead of calling copy constructors and destructors, so for
+ *	example vector< ObjRef<T> > does not touch reference counters.
+ *	Specialize by MD_TL_RELOCATABLE() for own types.
+ */
+template<class T>
+struct is_relocatable
+{
+	enum { value = False };
+};
+
+template<class T>
+struct is_relocatable<T*>
+{
+	enum { value = True };
+};
+
+/// Declares T relocatable, see is_relocatable. Use in namespace mdragon.
+#define MD_TL_RELOCATABLE(T) \
+	template<> struct is_relocatable< T > { enum { value = True }; };
+
+MD_TL_RELOCATABLE(char)
+MD_TL_RELOCATABLE(signed char)
+MD_TL_RELOCATABLE(unsigned char)
+MD_TL_RELOCATABLE(short)
+MD_TL_RELOCATABLE(unsigned short)
+MD_TL_RELOCATABLE(int)
+MD_TL_RELOCATABLE(unsigned int)
+MD_TL_RELOCATABLE(long)
+MD_TL_RELOCATABLE(unsigned long)
+MD_TL_RELOCATABLE(float)
+MD_TL_RELOCATABLE(double)
+
+/// Moves object from src to uninitialized memory at dst, src is destroyed.
+/**
+ *	Moves by move constructor if compiler supports it, otherwise copies.
+ *	Overloaded for types having cheaper way, like string.
+ */
+template <class T> inline
+void relocate( T * dst, T * src )
+{
+	assert ( dst != NULL && src != NULL );
+#ifdef MD_TL_RVALUE_REFERENCES
+	new ( dst ) T ( mdragon::move( *src ) );
+#else
+	new ( dst ) T ( *src );
+#endif
+	src->~T ();
+}
+
 
 template <class T> inline
 void destroy( T * pointer )
@@ -54,6 +129,26 @@ ForwardIterator uninitialized_move( InputIterator first, InputIterator last,
 	return result;
 }
 
+/// Moves [first, last) to uninitialized memory at result, source is destroyed.
+/**
+ *	Relocatable elements are moved by memmove(), others by relocate().
+ *	Ranges may overlap if result is lower than first.
+ */
+template <class T>
+T * uninitialized_move( T * first, T * last, T * result )
+{
+	if( is_relocatable<T>::value )
+	{
+		if( first != last && first != result )
+			memmove( result, first, (Int)( ( last - first ) * sizeof(T) ) );
+		return result + ( last - first );
+	}
+
+	for( ; first != last; ++first, ++result )
+		relocate( result, first );
+	return result;
+}
+
 template <class BidirectionalIterator1, class BidirectionalIterator2> 
 inline BidirectionalIterator2 uninitialized_move_backward( 
 		BidirectionalIterator1 first, BidirectionalIterator1 last, 
@@ -67,6 +162,25 @@ inline BidirectionalIterator2 uninitialized_move_backward(
 	return result;
 }
 
+/// Moves [first, last) to uninitialized memory ending at result, source is destroyed.
+/**
+ *	Ranges may overlap if result is higher than last.
+ */
+template <class T> 
+inline T * uninitialized_move_backward( T * first, T * last, T * result )
+{
+	if( is_relocatable<T>::value )
+	{
+		if( first != last && last != result )
+			memmove( result - ( last - first ), first, (Int)( ( last - first ) * sizeof(T) ) );
+		return result - ( last - first ) - 1;
+	}
+
+	for ( --first, --last, --result; last != first; --last, --result )
+		relocate( result, last );
+	return result;
+}
+
 template <class ForwardIterator, class T>
 void uninitialized_fill( ForwardIterator first, ForwardIterator last, 
                         const T & t )
@@ -96,7 +210,7 @@ public:
 	typedef T * pointer;
 	typedef const T * const_pointer;
 	typedef ptrdiff_t difference_type;
-	typedef size_type size_type;
+	typedef mdragon::size_type size_type;
 	typedef temporary_buffer<T> self;
 
 	inline explicit temporary_buffer( size_type size )
@@ -112,6 +112,66 @@ void quick_sort___ ( RandomAccessIterator first,
 }
 
 
+/// Stable LSD radix sort of range [first, last) by 32 bit unsigned key.
+/**
+ *	Sorts in ascending order of key( element ) in linear time, 8 bits per
+ *	pass. Passes where all keys have the same digit are skipped.
+ *	@param buffer - scratch array of at least last - first elements.
+ *	@param key - functor returning DWord sort key of element.
+ */
+template <class T, class KeyFunction>
+void radix_sort( T* first, T* last, T* buffer, KeyFunction key )
+{
+	ptrdiff_t n = last - first;
+
+	if( n < 2 )
+		return;
+
+	size_type count[4][256];
+	memset( count, 0, sizeof(count) );
+
+	for( T* p = first; p != last; ++p )
+	{
+		DWord k = key( *p );
+		++count[0][ k & 0xFF ];
+		++count[1][ ( k >> 8 ) & 0xFF ];
+		++count[2][ ( k >> 16 ) & 0xFF ];
+		++count[3][ k >> 24 ];
+	}
+
+	T* src = first;
+	T* dst = buffer;
+
+	for( Int pass = 0; pass < 4; pass++ )
+	{
+		size_type* c = count[pass];
+		Int shift = pass * 8;
+
+		if( c[ ( key( *src ) >> shift ) & 0xFF ] == (size_type)n )
+			continue;
+
+		size_type sum = 0;
+		for( Int i = 0; i < 256; i++ )
+		{
+			size_type t = c[i];
+			c[i] = sum;
+			sum += t;
+		}
+
+		for( ptrdiff_t i = 0; i < n; i++ )
+			dst[ c[ ( key( src[i] ) >> shift ) & 0xFF ]++ ] = src[i];
+
+		T* t = src;
+		src = dst;
+		dst = t;
+	}
+
+	if( src != first )
+		for( ptrdiff_t i = 0; i < n; i++ )
+			first[i] = src[i];
+}
+
+
 template <class RandomAccessIterator, class Key>
 RandomAccessIterator binary_find( RandomAccessIterator first, 
 		RandomAccessIterator last, const Key & key )
@@ -13,6 +13,10 @@ namespace mdragon
 {
 
 /// String class.
+/**
+ *	Strings up to 19 characters are kept in inplace buffer without memory
+ *	allocation, that covers most node, texture and file names.
+ */
 class string
 {
 public:
@@ -23,7 +27,7 @@ public:
 	typedef const Char & const_reference;
 	typedef Char * pointer;
 	typedef Int difference_type;
-	typedef size_type size_type;
+	typedef mdragon::size_type size_type;
 
 	///////////////////////////////////////////////////////////////////
 	// Constructors & destructor.
@@ -36,6 +40,15 @@ public:
 	/// Copy constructor.
 	string( const string & src );
 
+#ifdef MD_TL_RVALUE_REFERENCES
+	/// Move constructor. Takes buffer of src, src becomes empty.
+	inline string( string && src )
+	{
+		init();
+		swap( src );
+	}
+#endif
+
 	/// Construct from substring.
 	/**
 	 *	@param src - string to copy from.
@@ -660,6 +673,15 @@ public:
 	/// Assigns to this content of src.
 	string & operator = ( const string & src );
 
+#ifdef MD_TL_RVALUE_REFERENCES
+	/// Move assignment. Exchanges buffers with src.
+	inline string & operator = ( string && src )
+	{
+		swap( src );
+		return *this;
+	}
+#endif
+
 	/// Assigns to this content of src.
 	string & operator = ( const Char * src );
 
@@ -745,6 +767,19 @@ void swap( string & a, string & b )
 	a.swap(b);
 }
 
+/// Moves string to uninitialized memory, see relocate().
+/**
+ *	Strings up to 19 characters live in inplace_buffer, so string is not
+ *	relocatable by memcpy(). Longer strings pass their heap buffer by swap()
+ *	instead of copying it.
+ */
+inline void relocate( string * dst, string * src )
+{
+	new ( dst ) string;
+	dst->swap( *src );
+	src->~string();
+}
+
 } //namespace mdragon
 
 #endif // __MD_STRING_H__
@@ -130,7 +130,7 @@ public:
 	typedef T * pointer;
 	typedef const T * const_pointer;
 	typedef ptrdiff_t difference_type;
-	typedef size_type size_type;
+	typedef mdragon::size_type size_type;
 	typedef vector<T, BufAlloc> self;
 
 
@@ -151,6 +151,16 @@ public:
 	/// Copy constructor.
 	vector( const self & src );
 
+#ifdef MD_TL_RVALUE_REFERENCES
+	/// Move constructor. Takes elements of src, src becomes empty.
+	inline vector( self && src )
+	{
+		data_size = 0;
+		update_iterators();
+		swap( src );
+	}
+#endif
+
 	/// Destructor.
 	~vector();
 
@@ -222,6 +232,19 @@ public:
 		return *this;
 	}
 
+#ifdef MD_TL_RVALUE_REFERENCES
+	/// Move assignment operator. Takes elements of src, src becomes empty.
+	inline self & operator = ( self && src )
+	{
+		if( this != &src )
+		{
+			clear();
+			swap( src );
+		}
+		return *this;
+	}
+#endif
+
 	/// Empties the vector and inserts n coopies of t.
 	void assign( size_type n, const T & t );
 
@@ -279,6 +302,88 @@ public:
 	/// Inserts a new element at the end.
 	void push_back( const_reference t );
 
+#ifdef MD_TL_RVALUE_REFERENCES
+
+	/// Inserts a new element at the end, moving t.
+	inline void push_back( T && t )
+	{
+		emplace_back( mdragon::move( t ) );
+	}
+
+	/// Constructs a new element at the end from arguments.
+	/**
+	 *	@return Returns reference to the new element.
+	 */
+	template<class... Args>
+	reference emplace_back( Args&&... args )
+	{
+		reserve( data_size + 1 );
+		new ( end() ) T ( mdragon::forward<Args>( args )... );
+		++data_size;
+		update_iterators();
+		return back();
+	}
+
+#else
+
+	/// Constructs a new element at the end by default constructor.
+	/**
+	 *	Fill the element in place instead of copying it by push_back().
+	 *	@return Returns reference to the new element.
+	 */
+	reference emplace_back()
+	{
+		reserve( data_size + 1 );
+		new ( end() ) T ();
+		++data_size;
+		update_iterators();
+		return back();
+	}
+
+	/// Constructs a new element at the end from argument.
+	/**
+	 *	@return Returns reference to the new element.
+	 */
+	template<class A1>
+	reference emplace_back( const A1 & a1 )
+	{
+		reserve( data_size + 1 );
+		new ( end() ) T ( a1 );
+		++data_size;
+		update_iterators();
+		return back();
+	}
+
+	/// Constructs a new element at the end from arguments.
+	/**
+	 *	@return Returns reference to the new element.
+	 */
+	template<class A1, class A2>
+	reference emplace_back( const A1 & a1, const A2 & a2 )
+	{
+		reserve( data_size + 1 );
+		new ( end() ) T ( a1, a2 );
+		++data_size;
+		update_iterators();
+		return back();
+	}
+
+	/// Constructs a new element at the end from arguments.
+	/**
+	 *	@return Returns reference to the new element.
+	 */
+	template<class A1, class A2, class A3>
+	reference emplace_back( const A1 & a1, const A2 & a2, const A3 & a3 )
+	{
+		reserve( data_size + 1 );
+		new ( end() ) T ( a1, a2, a3 );
+		++data_size;
+		update_iterators();
+		return back();
+	}
+
+#endif
+
 
 	/// Same as push_back( t ).
 	inline self & operator += ( const_reference t )
@@ -288,7 +393,7 @@ public:
 	}
 
 	/// Inserts content of src at the end of vector.
-	template<class T, class BufAlloc2> inline
+	template<class BufAlloc2> inline
 	self & operator += ( const 
 			vector<T, BufAlloc2> & src )
 	{
@@ -461,6 +566,14 @@ vector<T,BufAlloc>::~vector()
 template<class T, class BufAlloc>
 void vector<T,BufAlloc>::push_back( const T & t )
 {
+	// t may be element of this vector, keep it alive over reallocation.
+	if( data_size == capacity() && &t >= begin() && &t < end() )
+	{
+		T copy_t( t );
+		push_back( copy_t );
+		return;
+	}
+
 	reserve( data_size + 1 );
 	construct( end(), t );
 	++data_size;
@@ -641,6 +754,13 @@ Bool operator >= ( const vector<T,BufAlloc1> & src,
 		dst.begin(), dst.end() ) >= 0;
 }
 
+/// Vector on dynamic buffer points only to its heap block, so it is relocatable.
+template<class T>
+struct is_relocatable< vector< T, dynamic_buffer<T> > >
+{
+	enum { value = True };
+};
+
 } //namespace mdragon
 
 #endif //__MTL_VECTOR_H__
@@ -8,7 +8,7 @@
 #ifndef __MOBILE_DRAGON__
 #define __MOBILE_DRAGON__
 
-#if !defined(MD_OS_WIN32) && !defined(MD_OS_WINCE) && !defined(MD_OS_SYMBIAN_S60) && !defined(MD_OS_SYMBIAN_UIQ)
+#if !defined(MD_OS_WIN32) && !defined(MD_OS_WINCE) && !defined(MD_OS_SYMBIAN_S60) && !defined(MD_OS_SYMBIAN_UIQ) && !defined(MD_OS_LINUX)
 #define MD_OS_PALM
 #endif
 
@@ -27,37 +27,50 @@
 #include "md_tl/string.h"
 #include "md_tl/vector.h"
 #include "md_tl/svector.h"
+#include "md_tl/hash.h"
 
 #include "md_core/fixed.h"
 #include "md_core/mdfixedmath.h"
 #include "md_core/vecmath.h"
+#include "md_core/simd.h"
 #include "md_core/randomize.h"
 #include "md_core/resource.h"
 #include "md_core/packdir.h"
+#include "md_core/packreader.h"
+#include "md_core/objpool.h"
 #include "md_core/object.h"
+#include "md_core/objgraph.h"
+#include "md_core/name.h"
 
 #include "md_bluetooth/bluetooth.h"
 #include "md_bluetooth/ibtconnection.h"
 #include "md_bluetooth/btnetwork.h"
 
-#include "md_sound/Music.h"
-#include "md_sound/Sound.h"
-#include "md_sound/SoundSystem.h"
+#include "md_sound/music.h"
+#include "md_sound/sound.h"
+#include "md_sound/soundsystem.h"
 
 #include "md_system/log.h"
 #include "md_system/time.h"
 #include "md_system/memoryman.h"
+#include "md_system/memtrack.h"
+#include "md_system/framebuffer.h"
+#include "md_system/workerpool.h"
 #include "md_system/input.h"
 #include "md_system/system.h"
+#include "md_system/framearena.h"
 
 #include "md_render3d/class_id.h"
 #include "md_render3d/color.h"
+#include "md_render3d/profiler.h"
 #include "md_render3d/collision.h"
 #include "md_render3d/polyclip.h"
 #include "md_render3d/texture.h"
 #include "md_render3d/texture_actor.h"
 #include "md_render3d/lightmap.h"
 #include "md_render3d/vertexbuffer.h"
+#include "md_render3d/vsoa.h"
+#include "md_render3d/vmorph.h"
 #include "md_render3d/material.h"
 #include "md_render3d/basic3d.h"
 #include "md_render3d/light.h"
@@ -66,13 +79,21 @@
 #include "md_render3d/joint3d.h"
 #include "md_render3d/actor3d.h"
 #include "md_render3d/dummy.h"
-#include "md_render3d/sprite3D.h"
+#include "md_render3d/sprite3d.h"
 #include "md_render3d/portal.h"
+#include "md_render3d/pvs.h"
+#include "md_render3d/portalcache.h"
 #include "md_render3d/mdmload.h"
 #include "md_render3d/font3d.h"
 #include "md_render3d/triangle.h"
+#include "md_render3d/tilebin.h"
+#include "md_render3d/depthsort.h"
+#include "md_render3d/hiz.h"
 #include "md_render3d/software3d.h"
 #include "md_render3d/render3d.h"
+#include "md_render3d/bvh.h"
+#include "md_render3d/lodmanager.h"
+#include "md_render3d/vtransform.h"
 #include "md_render3d/pcx.h"
 #include "md_render3d/camera.h"
 #include "md_render3d/particles.h"
@@ -90,5 +111,6 @@
 #include "md_render2d/render2d.h"
 
 #include "md_core/mdgame.h"
+#include "md_core/mdbenchmark.h"
 
 #endif // __MOBILE_DRAGON__